@@ -0,0 +1,448 @@
+/**
+ * @file benchmark.cc
+ * @brief Standalone microbenchmark of the cuts and variables in cuts.h,
+ * variables.h, and numu_variables.h over synthetic spills. The selection
+ * templates are instantiated on mock types mimicking the SRProxy layout, so
+ * the benchmark needs neither ROOT nor any input files.
+ * @author justin.mueller@colostate.edu
+*/
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "cuts.h"
+#include "variables.h"
+#include "numu_variables.h"
+#include "generator.h"
+#include "checks.h"
+
+/**
+ * Timing of a single benchmarked function.
+*/
+struct Result
+{
+    std::string name;
+    std::string level;
+    size_t calls;
+    double nanoseconds;
+};
+
+/**
+ * Runs functions over every object (spill, interaction, or particle) of a set
+ * of synthetic spills and records the best time per call over a number of
+ * repetitions. The results of the functions are accumulated into a checksum
+ * so that the evaluation cannot be optimized away.
+*/
+class Benchmark
+{
+public:
+    /**
+     * Constructor for Benchmark.
+     * @param s the synthetic spills to run over.
+     * @param r the number of repetitions (the fastest is kept).
+     * @param f only functions whose name contains this string are run.
+    */
+    Benchmark(const std::vector<caf::SRSpillProxy> & s, size_t r, const std::string & f)
+        : spills(s), repeat(r), filter(f), checksum(0) {}
+
+    /**
+     * Benchmarks a spill-level function.
+     * @tparam F the type of the function.
+     * @param name of the function.
+     * @param f the function, taking a const caf::SRSpillProxy *.
+     * @return none.
+    */
+    template<class F>
+        void spill(const std::string & name, F f)
+        {
+            time(name, "spill", [&]()
+            {
+                double sum(0);
+                for(const auto & sr : spills)
+                    sum += f(&sr);
+                return std::make_pair(spills.size(), sum);
+            });
+        }
+
+    /**
+     * Benchmarks an interaction-level function on the reco and the true
+     * interactions.
+     * @tparam TruthOnly if true, only the true interactions are used (for
+     * functions reading truth-only attributes).
+     * @tparam F the type of the function (generic over the interaction).
+     * @param name of the function.
+     * @param f the function.
+     * @return none.
+    */
+    template<bool TruthOnly = false, class F>
+        void interaction(const std::string & name, F f)
+        {
+            if constexpr (!TruthOnly)
+                time(name, "reco", [&]() { return over_interactions(&caf::SRSpillProxy::dlp, f); });
+            time(name, "true", [&]() { return over_interactions(&caf::SRSpillProxy::dlp_true, f); });
+        }
+
+    /**
+     * Benchmarks a particle-level function on the reco and the true
+     * particles.
+     * @tparam TruthOnly if true, only the true particles are used (for
+     * functions reading truth-only attributes).
+     * @tparam F the type of the function (generic over the particle).
+     * @param name of the function.
+     * @param f the function.
+     * @return none.
+    */
+    template<bool TruthOnly = false, class F>
+        void particle(const std::string & name, F f)
+        {
+            if constexpr (!TruthOnly)
+                time(name, "reco", [&]() { return over_particles(&caf::SRSpillProxy::dlp, f); });
+            time(name, "true", [&]() { return over_particles(&caf::SRSpillProxy::dlp_true, f); });
+        }
+
+    /**
+     * Writes the results as a table.
+     * @param out the stream to write to.
+     * @return none.
+    */
+    void report(std::ostream & out) const
+    {
+        size_t width(8);
+        for(const Result & r : results)
+            width = std::max(width, r.name.size());
+        out << std::left << std::setw(width) << "Function" << std::right << std::setw(7) << "Level"
+            << std::setw(12) << "Calls" << std::setw(12) << "ns/call" << std::setw(12) << "Mcalls/s" << "\n";
+        out << std::fixed;
+        for(const Result & r : results)
+        {
+            double per_call(r.calls > 0 ? r.nanoseconds / r.calls : 0);
+            out << std::left << std::setw(width) << r.name << std::right << std::setw(7) << r.level
+                << std::setw(12) << r.calls << std::setw(12) << std::setprecision(2) << per_call
+                << std::setw(12) << std::setprecision(2) << (per_call > 0 ? 1e3 / per_call : 0) << "\n";
+        }
+        out << "Checksum: " << std::setprecision(6) << checksum << "\n";
+    }
+
+    /**
+     * Writes the results as CSV (one row per function and level), e.g. for
+     * tracking the throughput across revisions.
+     * @param path of the output file.
+     * @return none.
+    */
+    void write_csv(const std::string & path) const
+    {
+        std::ofstream out(path);
+        out << "function,level,calls,ns_per_call\n" << std::fixed << std::setprecision(3);
+        for(const Result & r : results)
+            out << r.name << "," << r.level << "," << r.calls << "," << (r.calls > 0 ? r.nanoseconds / r.calls : 0) << "\n";
+    }
+
+private:
+    /**
+     * Applies a function to every reco (or true) interaction of the spills.
+     * @tparam V the pointer to the interaction vector (dlp or dlp_true).
+     * @tparam F the type of the function.
+     * @param v the pointer to the interaction vector.
+     * @param f the function.
+     * @return the number of calls and the sum of the results.
+    */
+    template<class V, class F>
+        std::pair<size_t, double> over_interactions(V v, F f) const
+        {
+            size_t calls(0);
+            double sum(0);
+            for(const auto & sr : spills)
+            {
+                for(const auto & i : sr.*v)
+                {
+                    sum += f(i);
+                    ++calls;
+                }
+            }
+            return std::make_pair(calls, sum);
+        }
+
+    /**
+     * Applies a function to every reco (or true) particle of the spills.
+     * @tparam V the pointer to the interaction vector (dlp or dlp_true).
+     * @tparam F the type of the function.
+     * @param v the pointer to the interaction vector.
+     * @param f the function.
+     * @return the number of calls and the sum of the results.
+    */
+    template<class V, class F>
+        std::pair<size_t, double> over_particles(V v, F f) const
+        {
+            size_t calls(0);
+            double sum(0);
+            for(const auto & sr : spills)
+            {
+                for(const auto & i : sr.*v)
+                {
+                    for(const auto & p : i.particles)
+                    {
+                        sum += f(p);
+                        ++calls;
+                    }
+                }
+            }
+            return std::make_pair(calls, sum);
+        }
+
+    /**
+     * Times a loop over the spills, keeping the fastest repetition.
+     * @tparam L the type of the loop.
+     * @param name of the function.
+     * @param level of the function (spill, reco, or true).
+     * @param loop returning the number of calls and the sum of the results.
+     * @return none.
+    */
+    template<class L>
+        void time(const std::string & name, const std::string & level, L loop)
+        {
+            if(!filter.empty() && name.find(filter) == std::string::npos)
+                return;
+            Result result{name, level, 0, 0};
+            for(size_t r(0); r < repeat; ++r)
+            {
+                auto start(std::chrono::steady_clock::now());
+                std::pair<size_t, double> outcome(loop());
+                double elapsed(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                if(r == 0 || elapsed < result.nanoseconds)
+                    result.nanoseconds = elapsed;
+                result.calls = outcome.first;
+                if(std::isfinite(outcome.second))
+                    checksum += outcome.second;
+            }
+            results.push_back(result);
+        }
+
+    const std::vector<caf::SRSpillProxy> & spills;
+    size_t repeat;
+    std::string filter;
+    std::vector<Result> results;
+    double checksum;
+};
+
+/**
+ * Preprocessor wrappers registering a function with the benchmark. The name
+ * of the function is used as the label. The truth-only variants skip the
+ * reco objects (for functions reading truth-only attributes).
+*/
+#define BENCH_SPILL(FN) bench.spill(#FN, [](const caf::SRSpillProxy * sr) -> double { return FN(sr); });
+#define BENCH_INTERACTION(FN) bench.interaction(#FN, [](const auto & i) -> double { return FN(i); });
+#define BENCH_TRUE_INTERACTION(FN) bench.interaction<true>(#FN, [](const auto & i) -> double { return FN(i); });
+#define BENCH_PARTICLE(FN) bench.particle(#FN, [](const auto & p) -> double { return FN(p); });
+#define BENCH_TRUE_PARTICLE(FN) bench.particle<true>(#FN, [](const auto & p) -> double { return FN(p); });
+
+/**
+ * Prints the usage of the benchmark.
+ * @param name of the executable.
+ * @return none.
+*/
+void usage(const char * name)
+{
+    std::cout << "Usage: " << name << " [options]\n"
+              << "  --spills N             number of synthetic spills (default 10000)\n"
+              << "  --repeat N             repetitions per function, fastest kept (default 5)\n"
+              << "  --seed N               seed of the generator (default 12345)\n"
+              << "  --interactions X       mean number of interactions per spill (default 6)\n"
+              << "  --particles X          mean number of particles per interaction (default 4)\n"
+              << "  --pid-mix a,b,c,d,e    relative fractions of photons, electrons, muons, pions, protons\n"
+              << "  --primary-fraction X   fraction of primary particles (default 0.7)\n"
+              << "  --neutrino-fraction X  fraction of neutrino interactions (default 0.2)\n"
+              << "  --filter S             only run functions whose name contains S\n"
+              << "  --csv FILE             also write the results to FILE as CSV\n"
+              << "  --check                check the optimized code against its reference and exit\n";
+}
+
+int main(int argc, char ** argv)
+{
+    GeneratorConfig config;
+    size_t nspills(10000), repeat(5);
+    std::string filter, csv;
+    bool check(false);
+    for(int a(1); a < argc; ++a)
+    {
+        std::string arg(argv[a]);
+        if(arg == "--help" || arg == "-h")
+        {
+            usage(argv[0]);
+            return 0;
+        }
+        if(arg == "--check")
+        {
+            check = true;
+            continue;
+        }
+        if(a + 1 >= argc)
+        {
+            std::cerr << "Missing value for option " << arg << std::endl;
+            usage(argv[0]);
+            return 1;
+        }
+        std::string value(argv[++a]);
+        if(arg == "--spills") nspills = std::stoul(value);
+        else if(arg == "--repeat") repeat = std::max<size_t>(1, std::stoul(value));
+        else if(arg == "--seed") config.seed = std::stoul(value);
+        else if(arg == "--interactions") config.interactions = std::stod(value);
+        else if(arg == "--particles") config.particles = std::stod(value);
+        else if(arg == "--primary-fraction") config.primary_fraction = std::stod(value);
+        else if(arg == "--neutrino-fraction") config.neutrino_fraction = std::stod(value);
+        else if(arg == "--filter") filter = value;
+        else if(arg == "--csv") csv = value;
+        else if(arg == "--pid-mix")
+        {
+            std::istringstream fractions(value);
+            std::string f;
+            for(size_t k(0); k < 5 && std::getline(fractions, f, ','); ++k)
+                config.pid_fraction[k] = std::stod(f);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<caf::SRSpillProxy> spills(nspills);
+    SpillGenerator generator(config);
+    size_t ninteractions(0), nparticles(0);
+    for(size_t s(0); s < nspills; ++s)
+    {
+        generator.generate(spills[s], s);
+        for(const auto & i : spills[s].dlp)
+            nparticles += i.particles.size();
+        ninteractions += spills[s].dlp.size();
+    }
+    std::cout << "Generated " << nspills << " spills with " << ninteractions << " reco interactions and "
+              << nparticles << " reco particles." << std::endl;
+
+    if(check)
+    {
+        bool pass(check_batch(spills, &caf::SRSpillProxy::dlp, "reco", std::cout));
+        pass = check_batch(spills, &caf::SRSpillProxy::dlp_true, "true", std::cout) && pass;
+        pass = check_composites(spills, &caf::SRSpillProxy::dlp, "reco", std::cout) && pass;
+        pass = check_composites(spills, &caf::SRSpillProxy::dlp_true, "true", std::cout) && pass;
+        return pass ? 0 : 1;
+    }
+
+    Benchmark bench(spills, repeat, filter);
+
+    BENCH_SPILL(cuts::crtpmt_veto)
+    BENCH_SPILL(cuts::crtpmt_veto_data)
+
+    BENCH_INTERACTION(cuts::no_cut)
+    BENCH_INTERACTION(cuts::matched)
+    BENCH_INTERACTION(cuts::wellreco)
+    BENCH_INTERACTION(cuts::valid_flashmatch)
+    BENCH_INTERACTION(cuts::count_primaries)
+    BENCH_INTERACTION(cuts::cut_mask)
+    bench.interaction("cuts::topology", [](const auto & i) -> double { return cuts::topology(i).size(); });
+    BENCH_INTERACTION(cuts::fiducial_cut)
+    BENCH_INTERACTION(cuts::containment_cut)
+    BENCH_INTERACTION(cuts::topological_1mu1p_cut)
+    BENCH_INTERACTION(cuts::topological_1muNp_cut)
+    BENCH_INTERACTION(cuts::topological_1muX_cut)
+    BENCH_INTERACTION(cuts::flash_cut)
+    BENCH_INTERACTION(cuts::flash_cut_data)
+    BENCH_INTERACTION(cuts::fiducial_containment_cut)
+    BENCH_INTERACTION(cuts::fiducial_containment_topological_1mu1p_cut)
+    BENCH_INTERACTION(cuts::fiducial_containment_topological_1muNp_cut)
+    BENCH_INTERACTION(cuts::fiducial_containment_topological_1muX_cut)
+    BENCH_INTERACTION(cuts::all_1mu1p_cut)
+    BENCH_INTERACTION(cuts::all_1muNp_cut)
+    BENCH_INTERACTION(cuts::all_1muX_cut)
+    BENCH_INTERACTION(cuts::all_1mu1p_data_cut)
+    BENCH_INTERACTION(cuts::all_1muNp_data_cut)
+    BENCH_INTERACTION(cuts::all_1muX_data_cut)
+    BENCH_INTERACTION(cuts::neutrino)
+    BENCH_INTERACTION(cuts::cosmic)
+    BENCH_INTERACTION(cuts::matched_neutrino)
+    BENCH_INTERACTION(cuts::wellreco_neutrino)
+    BENCH_INTERACTION(cuts::matched_cosmic)
+    BENCH_INTERACTION(cuts::signal_1mu1p)
+    BENCH_INTERACTION(cuts::signal_1muNp)
+    BENCH_INTERACTION(cuts::signal_1muNp_Nnot1)
+    BENCH_INTERACTION(cuts::signal_1muX)
+    BENCH_INTERACTION(cuts::signal_1muX_notNp)
+    BENCH_INTERACTION(cuts::other_nu_1mu1p)
+    BENCH_INTERACTION(cuts::other_nu_1muNp)
+    BENCH_INTERACTION(cuts::other_nu_1muX)
+
+    BENCH_PARTICLE(cuts::final_state_signal)
+    BENCH_PARTICLE(cuts::muon)
+    BENCH_PARTICLE(cuts::matched_muon)
+    BENCH_PARTICLE(cuts::proton)
+    BENCH_PARTICLE(cuts::matched_proton)
+    BENCH_PARTICLE(cuts::cathode_crossing)
+    BENCH_PARTICLE(cuts::cathode_crossing_muon)
+    BENCH_PARTICLE(cuts::non_cathode_crossing_muon)
+    BENCH_PARTICLE(cuts::contained_tpc_muon)
+    BENCH_PARTICLE(cuts::wellreco_muon)
+
+    BENCH_INTERACTION(vars::count)
+    BENCH_INTERACTION(vars::image_id)
+    BENCH_INTERACTION(vars::id)
+    BENCH_INTERACTION(vars::cryostat)
+    BENCH_INTERACTION(vars::category)
+    BENCH_INTERACTION(vars::category_topology)
+    BENCH_TRUE_INTERACTION(vars::category_interaction_mode)
+    BENCH_INTERACTION(vars::count_particles)
+    BENCH_INTERACTION(vars::count_primaries)
+    BENCH_TRUE_INTERACTION(vars::neutrino_energy)
+    BENCH_INTERACTION(vars::flash_time)
+    BENCH_INTERACTION(vars::leading_muon_cosine_theta_xz)
+    BENCH_INTERACTION(vars::leading_proton_cosine_theta_xz)
+    BENCH_INTERACTION(vars::cosine_opening_angle)
+    BENCH_INTERACTION(vars::cosine_opening_angle_transverse)
+    BENCH_INTERACTION(vars::leading_muon_softmax)
+    BENCH_INTERACTION(vars::leading_proton_softmax)
+    BENCH_TRUE_INTERACTION(vars::proton_scattering_cosine)
+    BENCH_INTERACTION(vars::leading_proton_overlap)
+    bench.interaction("vars::summarize", [](const auto & i) -> double { return vars::summarize(i).visible_energy; });
+    BENCH_INTERACTION(vars::visible_energy)
+    BENCH_INTERACTION(vars::leading_muon_ke)
+    BENCH_INTERACTION(vars::leading_proton_ke)
+    BENCH_INTERACTION(vars::leading_muon_pt)
+    BENCH_INTERACTION(vars::leading_proton_pt)
+    BENCH_INTERACTION(vars::muon_polar_angle)
+    BENCH_INTERACTION(vars::muon_azimuthal_angle)
+    BENCH_INTERACTION(vars::opening_angle)
+    BENCH_INTERACTION(vars::interaction_pt)
+    BENCH_INTERACTION(vars::phiT)
+    BENCH_INTERACTION(vars::alphaT)
+    BENCH_INTERACTION(vars::muon_softmax)
+    BENCH_INTERACTION(vars::proton_softmax)
+
+    BENCH_PARTICLE(vars::id)
+    BENCH_PARTICLE(vars::cryostat)
+    BENCH_PARTICLE(vars::primary)
+    BENCH_PARTICLE(vars::pid)
+    BENCH_PARTICLE(vars::primary_pid)
+    BENCH_PARTICLE(vars::csda_ke)
+    BENCH_PARTICLE(vars::calo_ke)
+    BENCH_PARTICLE(vars::csda_ke_muon)
+    BENCH_TRUE_PARTICLE(vars::energy_deposit)
+    BENCH_TRUE_PARTICLE(vars::ke_init)
+    BENCH_PARTICLE(vars::overlap)
+    BENCH_PARTICLE(vars::lowx)
+    BENCH_PARTICLE(vars::cosine_theta_xz)
+    BENCH_PARTICLE(vars::transverse_momentum)
+    BENCH_PARTICLE(vars::polar_angle)
+    BENCH_PARTICLE(vars::azimuthal_angle)
+
+    bench.report(std::cout);
+    if(!csv.empty())
+        bench.write_csv(csv);
+    return 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file checks.h
+ * @brief Header file defining consistency checks of the optimized selection
+ * code against the reference implementations, run over synthetic spills.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef CHECKS_H
+#define CHECKS_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "cuts.h"
+#include "variables.h"
+#include "numu_variables.h"
+#include "batch_kernels.h"
+
+/**
+ * Records the outcome of a consistency check: the number of values compared,
+ * the number of mismatches, and the largest difference seen.
+*/
+struct Check
+{
+    std::string name;
+    double tolerance;
+    bool relative;
+    size_t compared = 0;
+    size_t failed = 0;
+    double largest = 0;
+
+    /**
+     * Constructor for Check.
+     * @param n the name of the check.
+     * @param t the tolerance (0 for bitwise equality).
+     * @param r whether the tolerance is relative to the reference value.
+    */
+    Check(const std::string & n, double t, bool r=false) : name(n), tolerance(t), relative(r) {}
+
+    /**
+     * Compares a value with its reference.
+     * @param value the value to check.
+     * @param reference the reference value.
+     * @return none.
+    */
+    void compare(double value, double reference)
+    {
+        ++compared;
+        if(std::isnan(value) && std::isnan(reference))
+            return;
+        double difference(std::abs(value - reference));
+        if(!(difference <= largest))
+            largest = difference;
+        bool pass(tolerance == 0 ? std::memcmp(&value, &reference, sizeof(double)) == 0
+                                 : difference <= tolerance * (relative ? std::abs(reference) : 1.0));
+        failed += !pass;
+    }
+
+    /**
+     * Prints the outcome of the check.
+     * @param out the stream to write to.
+     * @return true if every value matched its reference.
+    */
+    bool report(std::ostream & out) const
+    {
+        out << (failed == 0 ? "PASS " : "FAIL ") << name << ": " << compared << " values, " << failed
+            << " mismatches, largest difference " << largest << "\n";
+        return failed == 0;
+    }
+};
+
+/**
+ * Compares the columns of a ParticleBatch with the scalar variables of
+ * variables.h/numu_variables.h within the tolerances documented in
+ * batch_kernels.h, and the kernels with a reference evaluation in which
+ * every product is rounded to double before it is summed (so that it cannot
+ * be contracted into a fused multiply-add), which must agree bitwise.
+ * @tparam V the pointer to the interaction vector (dlp or dlp_true).
+ * @param spills the synthetic spills.
+ * @param v the pointer to the interaction vector.
+ * @param level of the interactions (reco or true), for the report.
+ * @param out the stream to write the report to.
+ * @return true if all checks passed.
+*/
+template<class V>
+    bool check_batch(const std::vector<caf::SRSpillProxy> & spills, V v, const std::string & level, std::ostream & out)
+    {
+        constexpr double kTolerance = 1.0 / (1 << 21);
+        constexpr double kAngleTolerance = 1e-3;
+        Check pt("kTransverseMomentum (" + level + ")", kTolerance, true);
+        Check polar("kPolarAngle (" + level + ")", kAngleTolerance);
+        Check azimuthal("kAzimuthalAngle (" + level + ")", kAngleTolerance);
+        Check theta_xz("kCosineThetaXZ (" + level + ")", kTolerance);
+        Check opening("kCosineOpeningAngle (" + level + ")", kTolerance);
+        Check exact("kernels vs uncontracted reference (" + level + ")", 0);
+
+        ParticleBatch batch;
+        std::vector<double> dots;
+        for(const auto & sr : spills)
+        {
+            batch.reset();
+            batch.gather(sr.*v);
+            for(size_t k(0); k < (sr.*v).size(); ++k)
+            {
+                const auto & i((sr.*v)[k]);
+                for(size_t j(0); j < i.particles.size(); ++j)
+                {
+                    const auto & p(i.particles[j]);
+                    size_t n(batch.offsets[k] + j);
+                    pt.compare(batch.column(ParticleBatch::kTransverseMomentum)[n], vars::transverse_momentum(p));
+                    polar.compare(batch.column(ParticleBatch::kPolarAngle)[n], vars::polar_angle(p));
+                    azimuthal.compare(batch.column(ParticleBatch::kAzimuthalAngle)[n], vars::azimuthal_angle(p));
+                    // The scalar cosine_theta_xz and cosine_opening_angle use start_dir for true particles as well.
+                    if constexpr (!is_truth_v<std::decay_t<decltype(p)>>)
+                        theta_xz.compare(batch.column(ParticleBatch::kCosineThetaXZ)[n], vars::cosine_theta_xz(p));
+                }
+                if constexpr (!is_truth_v<std::decay_t<decltype(i)>>)
+                {
+                    if(!i.particles.empty())
+                        opening.compare(batch.value(ParticleBatch::kCosineOpeningAngle, k, ParticleBatch::kLeadingPair), vars::cosine_opening_angle(i));
+                }
+            }
+
+            size_t count(batch.px.size());
+            dots.resize(count);
+            kernels::cosine_opening_angle(batch.dx.data(), batch.dy.data(), batch.dz.data(),
+                                          batch.px.data(), batch.py.data(), batch.pz.data(), dots.data(), count);
+            for(size_t n(0); n < count; ++n)
+            {
+                double px(batch.px[n]), py(batch.py[n]), pz(batch.pz[n]);
+                double dx(batch.dx[n]), dy(batch.dy[n]), dz(batch.dz[n]);
+                volatile double pxx(px * px), pyy(py * py), dxx(dx * dx), dyy(dy * dy), dzz(dz * dz);
+                volatile double x(dx * px), y(dy * py), z(dz * pz);
+                exact.compare(batch.column(ParticleBatch::kTransverseMomentum)[n], std::sqrt(pxx + pyy));
+                exact.compare(batch.column(ParticleBatch::kAzimuthalAngle)[n], std::acos(dx / std::sqrt(dxx + dyy)));
+                exact.compare(batch.column(ParticleBatch::kCosineThetaXZ)[n], dz / std::sqrt(dxx + dzz));
+                exact.compare(dots[n], (x + y) + z);
+            }
+        }
+
+        bool pass(true);
+        for(const Check * c : {&pt, &polar, &azimuthal, &theta_xz, &opening, &exact})
+        {
+            if(c->compared > 0)
+                pass = c->report(out) && pass;
+        }
+        return pass;
+    }
+
+/**
+ * Compares each composite cut of cuts.h, and its mask representation applied
+ * to cut_mask(), with the original definition of the composite as a chain of
+ * the primitive cuts, which must agree on every interaction.
+ * @tparam V the pointer to the interaction vector (dlp or dlp_true).
+ * @param spills the synthetic spills.
+ * @param v the pointer to the interaction vector.
+ * @param level of the interactions (reco or true), for the report.
+ * @param out the stream to write the report to.
+ * @return true if all checks passed.
+*/
+template<class V>
+    bool check_composites(const std::vector<caf::SRSpillProxy> & spills, V v, const std::string & level, std::ostream & out)
+    {
+        using namespace cuts;
+        using T = std::decay_t<decltype((spills[0].*v)[0])>;
+        using F = bool (*)(const T &);
+        struct Composite
+        {
+            const char * name;
+            F cut;
+            F reference;
+        };
+        static const Composite composites[] = {
+            {"fiducial_containment_cut", &fiducial_containment_cut<T>,
+             [](const T & i) { return fiducial_cut<T>(i) && containment_cut<T>(i); }},
+            {"fiducial_containment_topological_1mu1p_cut", &fiducial_containment_topological_1mu1p_cut<T>,
+             [](const T & i) { return fiducial_cut<T>(i) && containment_cut<T>(i) && topological_1mu1p_cut<T>(i); }},
+            {"fiducial_containment_topological_1muNp_cut", &fiducial_containment_topological_1muNp_cut<T>,
+             [](const T & i) { return fiducial_cut<T>(i) && containment_cut<T>(i) && topological_1muNp_cut<T>(i); }},
+            {"fiducial_containment_topological_1muX_cut", &fiducial_containment_topological_1muX_cut<T>,
+             [](const T & i) { return fiducial_cut<T>(i) && containment_cut<T>(i) && topological_1muX_cut<T>(i); }},
+            {"all_1mu1p_cut", &all_1mu1p_cut<T>,
+             [](const T & i) { return topological_1mu1p_cut<T>(i) && fiducial_cut<T>(i) && flash_cut<T>(i) && containment_cut<T>(i); }},
+            {"all_1muNp_cut", &all_1muNp_cut<T>,
+             [](const T & i) { return topological_1muNp_cut<T>(i) && fiducial_cut<T>(i) && flash_cut<T>(i) && containment_cut<T>(i); }},
+            {"all_1muX_cut", &all_1muX_cut<T>,
+             [](const T & i) { return topological_1muX_cut<T>(i) && fiducial_cut<T>(i) && flash_cut<T>(i) && containment_cut<T>(i); }},
+            {"all_1mu1p_data_cut", &all_1mu1p_data_cut<T>,
+             [](const T & i) { return topological_1mu1p_cut<T>(i) && fiducial_cut<T>(i) && flash_cut_data<T>(i) && containment_cut<T>(i); }},
+            {"all_1muNp_data_cut", &all_1muNp_data_cut<T>,
+             [](const T & i) { return topological_1muNp_cut<T>(i) && fiducial_cut<T>(i) && flash_cut_data<T>(i) && containment_cut<T>(i); }},
+            {"all_1muX_data_cut", &all_1muX_data_cut<T>,
+             [](const T & i) { return topological_1muX_cut<T>(i) && fiducial_cut<T>(i) && flash_cut_data<T>(i) && containment_cut<T>(i); }},
+            {"matched_neutrino", &matched_neutrino<T>,
+             [](const T & i) { return i.match.size() > 0 && neutrino<T>(i); }},
+            {"wellreco_neutrino", &wellreco_neutrino<T>,
+             [](const T & i) { return wellreco<T>(i) && neutrino<T>(i); }},
+            {"matched_cosmic", &matched_cosmic<T>,
+             [](const T & i) { return i.match.size() > 0 && cosmic<T>(i); }},
+            {"signal_1mu1p", &signal_1mu1p<T>,
+             [](const T & i) { return topological_1mu1p_cut<T>(i) && neutrino<T>(i); }},
+            {"signal_1muNp", &signal_1muNp<T>,
+             [](const T & i) { return topological_1muNp_cut<T>(i) && neutrino<T>(i); }},
+            {"signal_1muNp_Nnot1", &signal_1muNp_Nnot1<T>,
+             [](const T & i) { return !topological_1mu1p_cut<T>(i) && topological_1muNp_cut<T>(i) && neutrino<T>(i); }},
+            {"signal_1muX", &signal_1muX<T>,
+             [](const T & i) { return topological_1muX_cut<T>(i) && neutrino<T>(i); }},
+            {"signal_1muX_notNp", &signal_1muX_notNp<T>,
+             [](const T & i) { return !topological_1muNp_cut<T>(i) && topological_1muX_cut<T>(i) && neutrino<T>(i); }},
+            {"other_nu_1mu1p", &other_nu_1mu1p<T>,
+             [](const T & i) { return !topological_1mu1p_cut<T>(i) && neutrino<T>(i); }},
+            {"other_nu_1muNp", &other_nu_1muNp<T>,
+             [](const T & i) { return !topological_1muNp_cut<T>(i) && neutrino<T>(i); }},
+            {"other_nu_1muX", &other_nu_1muX<T>,
+             [](const T & i) { return !topological_1muX_cut<T>(i) && neutrino<T>(i); }}
+        };
+
+        Check direct("composite cuts vs reference chains (" + level + ")", 0);
+        Check masked("composite cut masks vs reference chains (" + level + ")", 0);
+        std::vector<size_t> passed(std::size(composites), 0);
+        for(const auto & sr : spills)
+        {
+            for(const auto & i : sr.*v)
+            {
+                uint32_t mask(cut_mask(i));
+                for(size_t c(0); c < std::size(composites); ++c)
+                {
+                    bool reference(composites[c].reference(i));
+                    direct.compare(composites[c].cut(i), reference);
+                    masked.compare(passes(mask, mask_cut(composites[c].cut)), reference);
+                    passed[c] += reference;
+                }
+            }
+        }
+
+        bool pass(direct.report(out));
+        pass = masked.report(out) && pass;
+        for(size_t c(0); c < std::size(composites); ++c)
+        {
+            // A composite that never passes (or always passes) is not tested by the comparison.
+            if(passed[c] == 0 || passed[c] * std::size(composites) == masked.compared)
+                out << "WARNING " << composites[c].name << " (" << level << ") passes on " << passed[c] << " interactions\n";
+        }
+        return pass;
+    }
+#endif
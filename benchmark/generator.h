@@ -0,0 +1,210 @@
+/**
+ * @file generator.h
+ * @brief Header file defining a generator of synthetic spills (reco and true
+ * interactions with their particles) for the standalone benchmark.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cmath>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "record_traits.h"
+
+/**
+ * Parameters of the synthetic spills. The defaults give multiplicities and a
+ * PID mix loosely resembling the ML reconstruction output for BNB simulation
+ * (a handful of mostly cosmic interactions per spill, a few particles per
+ * interaction, muons and protons dominating the primaries).
+*/
+struct GeneratorConfig
+{
+    double interactions = 6;
+    double particles = 4;
+    double pid_fraction[5] = {0.15, 0.10, 0.35, 0.10, 0.30};
+    double primary_fraction = 0.7;
+    double neutrino_fraction = 0.2;
+    double fiducial_fraction = 0.6;
+    double contained_fraction = 0.6;
+    double fmatched_fraction = 0.8;
+    double match_fraction = 0.8;
+    double mean_ke = 200;
+    unsigned seed = 12345;
+};
+
+/**
+ * Generator of synthetic spills. The number of interactions per spill and of
+ * particles per interaction are Poisson distributed (at least one particle
+ * per interaction), the particle species follow the configured PID mix, and
+ * the kinetic energies are exponentially distributed. Neutrino interactions
+ * have their flash in the beam gate; cosmic interactions have a flash
+ * anywhere in [-2, 4] us.
+*/
+class SpillGenerator
+{
+public:
+    /**
+     * Constructor for SpillGenerator.
+     * @param c the parameters of the synthetic spills.
+    */
+    SpillGenerator(const GeneratorConfig & c)
+        : config(c), engine(c.seed), uniform(0, 1), ninteractions(c.interactions), nparticles(c.particles > 1 ? c.particles - 1 : 0),
+          species(std::begin(c.pid_fraction), std::end(c.pid_fraction)), ke(1.0 / c.mean_ke) {}
+
+    /**
+     * Fills a spill with synthetic reco and true interactions.
+     * @param sr the spill to fill.
+     * @param evt the event number of the spill.
+     * @return none.
+    */
+    void generate(caf::SRSpillProxy & sr, unsigned evt)
+    {
+        sr.hdr.run = 1;
+        sr.hdr.subrun = evt / 1000;
+        sr.hdr.evt = evt;
+        sr.hdr.triggerinfo.global_trigger_det_time = 1500 + 20 * uniform(engine);
+
+        size_t nreco(ninteractions(engine)), ntrue(ninteractions(engine));
+        sr.dlp.values.resize(nreco);
+        sr.dlp_true.values.resize(ntrue);
+        int64_t particle_id(0);
+        for(size_t k(0); k < nreco; ++k)
+            fill(sr.dlp.values[k], k, ntrue, particle_id);
+        int64_t first_true(particle_id);
+        for(size_t k(0); k < ntrue; ++k)
+            fill(sr.dlp_true.values[k], k, nreco, particle_id);
+
+        for(auto & i : sr.dlp.values)
+            for(auto & p : i.particles.values)
+                if(particle_id > first_true && uniform(engine) < config.match_fraction)
+                    add_match(p, first_true + int64_t(engine() % (particle_id - first_true)));
+        for(auto & i : sr.dlp_true.values)
+            for(auto & p : i.particles.values)
+                if(first_true > 0 && uniform(engine) < config.match_fraction)
+                    add_match(p, int64_t(engine() % first_true));
+
+        sr.ncrtpmt_matches = engine() % 3;
+        sr.crtpmt_matches.values.resize(sr.ncrtpmt_matches);
+        for(auto & c : sr.crtpmt_matches.values)
+        {
+            c.flashGateTime = 4 * uniform(engine) - 1;
+            c.flashClassification = engine() % 2;
+        }
+    }
+
+private:
+    /**
+     * Adds a match (with a random overlap) to an interaction or particle.
+     * @tparam T the type of the object.
+     * @param obj the object to add the match to.
+     * @param id the id of the matched object.
+     * @return none.
+    */
+    template<class T>
+        void add_match(T & obj, int64_t id)
+        {
+            obj.match.values.push_back(id);
+            obj.match_overlap.values.push_back(uniform(engine));
+        }
+
+    /**
+     * Fills a single interaction and its particles.
+     * @tparam I the type of interaction (true or reco).
+     * @param interaction the interaction to fill.
+     * @param k the index of the interaction within the spill.
+     * @param nother the number of interactions on the other (true or reco)
+     * side of the spill, used for matching.
+     * @param particle_id the next free particle id within the spill.
+     * @return none.
+    */
+    template<class I>
+        void fill(I & interaction, size_t k, size_t nother, int64_t & particle_id)
+        {
+            interaction.id = k;
+            interaction.image_id = engine() % 5;
+            interaction.volume_id = engine() % 2;
+            interaction.is_fiducial = uniform(engine) < config.fiducial_fraction;
+            interaction.is_contained = uniform(engine) < config.contained_fraction;
+            interaction.vertex[0] = (interaction.volume_id == 0 ? -1 : 1) * (61.94 + 296 * uniform(engine));
+            interaction.vertex[1] = -181.86 + 316 * uniform(engine);
+            interaction.vertex[2] = -894.95 + 1790 * uniform(engine);
+            interaction.is_neutrino = uniform(engine) < config.neutrino_fraction;
+            interaction.fmatched = uniform(engine) < config.fmatched_fraction;
+            interaction.flash_time = interaction.fmatched ? (interaction.is_neutrino ? 1.6f * uniform(engine) : 6 * uniform(engine) - 2) : NAN;
+            interaction.nu_current_type = interaction.is_neutrino ? int(uniform(engine) < 0.3) : -1;
+            interaction.nu_pdg_code = interaction.is_neutrino ? 14 : -1;
+            interaction.nu_interaction_mode = interaction.is_neutrino ? int(engine() % 12) : -1;
+            interaction.nu_energy_init = interaction.is_neutrino ? 0.2f + 2 * uniform(engine) : NAN;
+            interaction.nu_id = interaction.is_neutrino ? 0 : -1;
+            interaction.match.values.clear();
+            interaction.match_overlap.values.clear();
+            if(nother > 0 && uniform(engine) < config.match_fraction)
+                add_match(interaction, int64_t(engine() % nother));
+
+            size_t n(1 + nparticles(engine));
+            interaction.particles.values.resize(n);
+            int primaries(0);
+            for(auto & p : interaction.particles.values)
+            {
+                p.id = particle_id++;
+                p.pid = species(engine);
+                p.is_primary = uniform(engine) < config.primary_fraction;
+                primaries += p.is_primary;
+                p.csda_ke = ke(engine);
+                p.calo_ke = p.csda_ke * (0.8f + 0.4f * uniform(engine));
+                p.length = p.csda_ke / 2.5f;
+                p.is_contained = uniform(engine) < config.contained_fraction;
+                p.volume_id = interaction.volume_id;
+                float d[3], norm(0);
+                for(size_t i(0); i < 3; ++i)
+                {
+                    d[i] = 2 * uniform(engine) - 1;
+                    norm += d[i] * d[i];
+                }
+                norm = std::sqrt(norm);
+                float momentum(std::sqrt(p.csda_ke * (p.csda_ke + 2 * 105.7f)));
+                for(size_t i(0); i < 3; ++i)
+                {
+                    p.start_dir[i] = d[i] / norm;
+                    p.momentum[i] = momentum * d[i] / norm;
+                    p.start_point[i] = interaction.vertex[i];
+                    p.end_point[i] = interaction.vertex[i] + p.length * d[i] / norm;
+                }
+                float total(0);
+                for(size_t s(0); s < 5; ++s)
+                {
+                    p.pid_scores[s] = uniform(engine);
+                    total += p.pid_scores[s];
+                }
+                for(size_t s(0); s < 5; ++s)
+                    p.pid_scores[s] = p.pid_scores[s] / total;
+                p.match.values.clear();
+                p.match_overlap.values.clear();
+                if constexpr (is_truth_v<I>)
+                {
+                    p.energy_deposit = p.csda_ke * (0.9f + 0.1f * uniform(engine));
+                    p.energy_init = p.csda_ke + 105.7f;
+                    for(size_t i(0); i < 3; ++i)
+                    {
+                        p.truth_start_dir[i] = p.start_dir[i];
+                        p.truth_momentum[i] = p.momentum[i];
+                    }
+                }
+            }
+            interaction.num_particles = n;
+            interaction.num_primaries = primaries;
+        }
+
+    GeneratorConfig config;
+    std::mt19937 engine;
+    std::uniform_real_distribution<float> uniform;
+    std::poisson_distribution<size_t> ninteractions;
+    std::poisson_distribution<size_t> nparticles;
+    std::discrete_distribution<int> species;
+    std::exponential_distribution<float> ke;
+};
+#endif
@@ -0,0 +1,190 @@
+/**
+ * @file SRProxy.h
+ * @brief Mock of the sbnanaobj SRProxy types used by the standalone
+ * benchmark. Only the attributes read by the cuts and variables in include/
+ * are provided, with the same names, types, and access patterns (implicit
+ * conversion of each attribute, indexed arrays, and vectors) as the real
+ * proxies.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef MOCK_SRPROXY_H
+#define MOCK_SRPROXY_H
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace caf
+{
+    /**
+     * Mock of a proxied attribute. Like the real Proxy<T>, it converts
+     * implicitly to T, so arithmetic on attributes resolves to the same
+     * overloads (e.g. single precision for float attributes).
+     * @tparam T the type of the attribute.
+    */
+    template<class T>
+    struct Proxy
+    {
+        T value{};
+
+        Proxy() {}
+        Proxy(T v) : value(v) {}
+        operator T() const { return value; }
+    };
+
+    /**
+     * Mock of a proxied fixed-size array attribute.
+     * @tparam T the type of the elements.
+     * @tparam N the size of the array.
+    */
+    template<class T, size_t N>
+    struct ProxyArray
+    {
+        Proxy<T> values[N];
+
+        const Proxy<T> & operator[](size_t i) const { return values[i]; }
+        Proxy<T> & operator[](size_t i) { return values[i]; }
+    };
+
+    /**
+     * Mock of a proxied vector attribute.
+     * @tparam T the type of the elements.
+    */
+    template<class T>
+    struct ProxyVector
+    {
+        std::vector<T> values;
+
+        size_t size() const { return values.size(); }
+        bool empty() const { return values.empty(); }
+        const T & operator[](size_t i) const { return values[i]; }
+        T & operator[](size_t i) { return values[i]; }
+        typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+        typename std::vector<T>::const_iterator end() const { return values.end(); }
+    };
+
+    struct SRParticleDLP {};
+    struct SRParticleTruthDLP {};
+    struct SRInteractionDLP {};
+    struct SRInteractionTruthDLP {};
+    struct StandardRecord {};
+
+    template<>
+    struct Proxy<SRParticleDLP>
+    {
+        Proxy<int64_t> id;
+        Proxy<int> pid;
+        Proxy<bool> is_primary;
+        Proxy<float> csda_ke;
+        Proxy<float> calo_ke;
+        Proxy<float> length;
+        Proxy<bool> is_contained;
+        Proxy<int> volume_id;
+        ProxyVector<Proxy<int64_t>> match;
+        ProxyVector<Proxy<float>> match_overlap;
+        ProxyArray<float, 3> start_point;
+        ProxyArray<float, 3> end_point;
+        ProxyArray<float, 3> start_dir;
+        ProxyArray<float, 3> momentum;
+        ProxyArray<float, 5> pid_scores;
+    };
+
+    template<>
+    struct Proxy<SRParticleTruthDLP>
+    {
+        Proxy<int64_t> id;
+        Proxy<int> pid;
+        Proxy<bool> is_primary;
+        Proxy<float> csda_ke;
+        Proxy<float> calo_ke;
+        Proxy<float> energy_deposit;
+        Proxy<float> energy_init;
+        Proxy<float> length;
+        Proxy<bool> is_contained;
+        Proxy<int> volume_id;
+        ProxyVector<Proxy<int64_t>> match;
+        ProxyVector<Proxy<float>> match_overlap;
+        ProxyArray<float, 3> start_point;
+        ProxyArray<float, 3> end_point;
+        ProxyArray<float, 3> start_dir;
+        ProxyArray<float, 3> momentum;
+        ProxyArray<float, 3> truth_start_dir;
+        ProxyArray<float, 3> truth_momentum;
+        ProxyArray<float, 5> pid_scores;
+    };
+
+    using SRParticleDLPProxy = Proxy<SRParticleDLP>;
+    using SRParticleTruthDLPProxy = Proxy<SRParticleTruthDLP>;
+
+    /**
+     * Attributes shared by the reco and true interactions.
+     * @tparam P the particle type of the interaction.
+    */
+    template<class P>
+    struct InteractionProxyBase
+    {
+        Proxy<int64_t> id;
+        Proxy<int64_t> image_id;
+        Proxy<int> volume_id;
+        Proxy<bool> is_fiducial;
+        Proxy<bool> is_contained;
+        ProxyArray<float, 3> vertex;
+        Proxy<float> flash_time;
+        Proxy<int> fmatched;
+        Proxy<bool> is_neutrino;
+        Proxy<int> nu_current_type;
+        Proxy<int> nu_pdg_code;
+        Proxy<int> nu_interaction_mode;
+        Proxy<int> num_particles;
+        Proxy<int> num_primaries;
+        Proxy<float> nu_energy_init;
+        Proxy<int64_t> nu_id;
+        ProxyVector<Proxy<int64_t>> match;
+        ProxyVector<Proxy<float>> match_overlap;
+        ProxyVector<P> particles;
+    };
+
+    template<>
+    struct Proxy<SRInteractionDLP> : InteractionProxyBase<SRParticleDLPProxy> {};
+
+    template<>
+    struct Proxy<SRInteractionTruthDLP> : InteractionProxyBase<SRParticleTruthDLPProxy> {};
+
+    using SRInteractionDLPProxy = Proxy<SRInteractionDLP>;
+    using SRInteractionTruthDLPProxy = Proxy<SRInteractionTruthDLP>;
+
+    struct SRCRTPMTMatchProxy
+    {
+        Proxy<float> flashGateTime;
+        Proxy<int> flashClassification;
+    };
+
+    struct SRTriggerProxy
+    {
+        Proxy<double> global_trigger_det_time;
+    };
+
+    struct SRHeaderProxy
+    {
+        Proxy<unsigned> run;
+        Proxy<unsigned> subrun;
+        Proxy<unsigned> evt;
+        SRTriggerProxy triggerinfo;
+    };
+
+    template<>
+    struct Proxy<StandardRecord>
+    {
+        SRHeaderProxy hdr;
+        ProxyVector<SRInteractionDLPProxy> dlp;
+        ProxyVector<SRInteractionTruthDLPProxy> dlp_true;
+        Proxy<int> ncrtpmt_matches;
+        ProxyVector<SRCRTPMTMatchProxy> crtpmt_matches;
+    };
+
+    using SRSpillProxy = Proxy<StandardRecord>;
+    using StandardRecordProxy = SRSpillProxy;
+}
+#endif
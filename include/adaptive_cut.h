@@ -0,0 +1,151 @@
+/**
+ * @file adaptive_cut.h
+ * @brief Header file defining a conjunction of cuts whose evaluation order
+ * adapts to the pass rates and costs observed at runtime.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef ADAPTIVE_CUT_H
+#define ADAPTIVE_CUT_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "cut_algebra.h"
+#include "spill_entry.h"
+
+template<class E>
+struct AdaptiveCut;
+
+/**
+ * Opt-in adaptive version of a cut conjunction (see cuts::And). For the
+ * first N spills every term is evaluated on every interaction (no
+ * short-circuit), and the pass rate and the average time of each term are
+ * recorded. The terms are evaluated in the compile-time order during this
+ * learning window. On the first spill after the window, the terms are
+ * reordered by measured cost per rejected interaction and the chosen order
+ * is logged; the rest of the run uses the new order with short-circuit
+ * evaluation. The result of the conjunction never depends on the order. With
+ * N = 0 the compile-time order is used throughout.
+ * @tparam Es the terms of the conjunction.
+*/
+template<class... Es>
+struct AdaptiveCut<cuts::And<Es...>>
+{
+    static constexpr size_t kTerms = sizeof...(Es);
+
+    std::string name;
+    std::vector<std::string> labels;
+    size_t learning_spills;
+    bool learning;
+    size_t spills = 0;
+    std::array<size_t, kTerms> order = cuts::And<Es...>::order;
+    std::array<uint64_t, kTerms> evaluated{};
+    std::array<uint64_t, kTerms> passed{};
+    std::array<double, kTerms> elapsed{};
+
+    SpillEntry current;
+
+    /**
+     * Constructor for AdaptiveCut.
+     * @param n the name of the cut (used for logging).
+     * @param l the labels of the terms, in the written order of the
+     * conjunction (used for logging).
+     * @param nspills the number of spills in the learning window (0 disables
+     * the adaptive ordering).
+    */
+    AdaptiveCut(const std::string & n, const std::vector<std::string> & l, size_t nspills)
+        : name(n), labels(l), learning_spills(nspills), learning(nspills > 0)
+    {
+        labels.resize(kTerms);
+        for(size_t k(0); k < kTerms; ++k)
+            if(labels[k].empty()) labels[k] = "term " + std::to_string(k);
+    }
+
+    /**
+     * Applies the conjunction to an interaction.
+     * @tparam T the type of interaction (true or reco).
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param interaction to select on.
+     * @return true if the interaction passes every term of the conjunction.
+    */
+    template<class T>
+        bool operator()(const caf::SRSpillProxy* sr, const T & interaction)
+        {
+            using Fn = bool (*)(const T &);
+            static const Fn terms[kTerms] = {&Es::template evaluate<T>...};
+
+            if(learning)
+            {
+                if(!current.same(sr))
+                {
+                    current.set(sr);
+                    if(++spills > learning_spills) adapt();
+                }
+            }
+
+            if(!learning)
+            {
+                for(size_t k : order)
+                    if(!terms[k](interaction)) return false;
+                return true;
+            }
+
+            bool result(true);
+            for(size_t k : order)
+            {
+                auto start(std::chrono::steady_clock::now());
+                bool pass(terms[k](interaction));
+                elapsed[k] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                ++evaluated[k];
+                passed[k] += pass;
+                result = result && pass;
+            }
+            return result;
+        }
+
+    /**
+     * Ends the learning window: reorders the terms by measured cost per
+     * rejected interaction (ties keep the current order) and logs the chosen
+     * order. Terms that were never evaluated (no interactions during the
+     * window) are placed last, in their current order.
+     * @return none.
+    */
+    void adapt()
+    {
+        learning = false;
+        std::array<double, kTerms> rank;
+        for(size_t k(0); k < kTerms; ++k)
+        {
+            if(evaluated[k] == 0)
+            {
+                rank[k] = 1e30;
+                continue;
+            }
+            double pass(double(passed[k]) / evaluated[k]);
+            double cost(elapsed[k] / evaluated[k]);
+            rank[k] = cuts::cut_rank({cost, pass});
+        }
+        std::stable_sort(order.begin(), order.end(), [&rank](size_t a, size_t b) { return rank[a] < rank[b]; });
+
+        std::ostringstream message;
+        message << "AdaptiveCut " << name << ": order after " << learning_spills << " spills:" << std::fixed;
+        for(size_t k : order)
+        {
+            double pass(evaluated[k] > 0 ? double(passed[k]) / evaluated[k] : 0);
+            double cost(evaluated[k] > 0 ? elapsed[k] / evaluated[k] : 0);
+            message << " " << labels[k] << " (pass " << std::setprecision(3) << pass
+                    << ", " << std::setprecision(1) << cost << " ns)";
+        }
+        std::cout << message.str() << std::endl;
+    }
+};
+#endif
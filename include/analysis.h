@@ -27,6 +27,14 @@ namespace ana
     // Define "variables" for binning interactions by some categorical class.
     DEFINECAT();
 
+    // Define the stage reached in each selection cut flow.
+    VARDLP_FLOW_TTP(kFlowTTP_1mu1p,cuts::flow_1mu1p);
+    VARDLP_FLOW_TTP(kFlowTTP_1muNp,cuts::flow_1muNp);
+    VARDLP_FLOW_TTP(kFlowTTP_1muX,cuts::flow_1muX);
+    VARDLP_FLOW_PTT(kFlowPTT_1mu1p,cuts::flow_1mu1p);
+    VARDLP_FLOW_PTT(kFlowPTT_1muNp,cuts::flow_1muNp);
+    VARDLP_FLOW_PTT(kFlowPTT_1muX,cuts::flow_1muX);
+
     // Define variables that are broadcasted across each selection cut.
     TCATVAR(kCountTTP,count);
     RCATVAR(kCountPTT,count);
@@ -0,0 +1,233 @@
+/**
+ * @file async_writer.h
+ * @brief Header file defining an output stream that hands large buffers to a
+ * background thread for writing, used for the CSV logs of the selection.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <iostream>
+#include <streambuf>
+#include <condition_variable>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Stream buffer behind AsyncWriter. Formatted output is collected in a large
+ * buffer; when the buffer is full it is pushed onto a bounded queue and a
+ * background thread writes it to the file, while the producer continues with
+ * a recycled buffer. If the queue is full the producer waits, so the memory
+ * used is bounded by (depth + 2) buffers. Flushes of the stream (e.g.
+ * std::endl or std::flush) do not trigger a write. The file is synced to disk
+ * only once, when the writer is closed.
+*/
+class AsyncBuffer : public std::streambuf
+{
+public:
+    /**
+     * Constructor for AsyncBuffer.
+     * @param path of the output file (truncated if it exists).
+     * @param size of each buffer in bytes.
+     * @param depth the maximum number of full buffers waiting to be written.
+    */
+    AsyncBuffer(const std::string & path, size_t size, size_t depth)
+        : name(path), buffer_size(size), queue_depth(depth), descriptor(-1), stopping(false), failed(false)
+    {
+        descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(descriptor < 0)
+        {
+            std::cerr << "AsyncWriter: unable to open " << path << " (" << std::strerror(errno) << ")" << std::endl;
+            failed = true;
+            return;
+        }
+        current.resize(buffer_size);
+        setp(current.data(), current.data() + current.size());
+        worker = std::thread(&AsyncBuffer::drain, this);
+    }
+
+    ~AsyncBuffer() { close(); }
+
+    /**
+     * Writes the pending output, waits for the background thread, syncs the
+     * file to disk, and closes it. Further output is discarded.
+     * @return true if all output was written successfully.
+    */
+    bool close()
+    {
+        if(descriptor < 0)
+            return !failed;
+        hand_off();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        filled.notify_one();
+        worker.join();
+        if(::fsync(descriptor) != 0 || ::close(descriptor) != 0)
+            failed = true;
+        descriptor = -1;
+        setp(nullptr, nullptr);
+        if(failed)
+            std::cerr << "AsyncWriter: error writing " << name << std::endl;
+        return !failed;
+    }
+
+protected:
+    /**
+     * Called when the current buffer is full: hands it off and continues
+     * with an empty one.
+     * @param c the character that did not fit.
+     * @return c, or EOF if the writer is closed.
+    */
+    int_type overflow(int_type c) override
+    {
+        if(descriptor < 0)
+            return traits_type::eof();
+        hand_off();
+        if(!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    /**
+     * Flushes of the stream are deliberately ignored; the data is written
+     * when a buffer fills up or when the writer is closed.
+     * @return 0 (success).
+    */
+    int sync() override { return 0; }
+
+private:
+    /**
+     * Pushes the filled part of the current buffer onto the queue (waiting
+     * while the queue is full) and takes a recycled buffer for the producer.
+     * @return none.
+    */
+    void hand_off()
+    {
+        size_t used(pptr() - pbase());
+        if(used == 0)
+            return;
+        current.resize(used);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            drained.wait(lock, [this] { return queue.size() < queue_depth; });
+            queue.push_back(std::move(current));
+            if(!spare.empty())
+            {
+                current = std::move(spare.back());
+                spare.pop_back();
+            }
+            else
+                current = std::vector<char>();
+        }
+        filled.notify_one();
+        current.resize(buffer_size);
+        setp(current.data(), current.data() + current.size());
+    }
+
+    /**
+     * Body of the background thread: writes the queued buffers to the file
+     * in order until the writer is closed and the queue is empty.
+     * @return none.
+    */
+    void drain()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true)
+        {
+            filled.wait(lock, [this] { return stopping || !queue.empty(); });
+            if(queue.empty())
+                return;
+            std::vector<char> data(std::move(queue.front()));
+            queue.pop_front();
+            lock.unlock();
+            drained.notify_one();
+
+            size_t written(0);
+            while(written < data.size())
+            {
+                ssize_t n(::write(descriptor, data.data() + written, data.size() - written));
+                if(n < 0 && errno == EINTR)
+                    continue;
+                if(n <= 0)
+                {
+                    failed = true;
+                    break;
+                }
+                written += n;
+            }
+
+            lock.lock();
+            if(spare.size() < 2)
+                spare.push_back(std::move(data));
+        }
+    }
+
+    std::string name;
+    size_t buffer_size;
+    size_t queue_depth;
+    int descriptor;
+    std::vector<char> current;
+    std::deque<std::vector<char>> queue;
+    std::vector<std::vector<char>> spare;
+    std::mutex mutex;
+    std::condition_variable filled;
+    std::condition_variable drained;
+    std::thread worker;
+    bool stopping;
+    bool failed;
+};
+
+/**
+ * Output stream for large text logs (e.g. the CSV output of the selection).
+ * Formatting happens on the producer side as with a std::ofstream, but the
+ * file is written by a background thread in large blocks, flushes are
+ * ignored, and the file is synced to disk only when the writer is closed (or
+ * destroyed). Each writer has a single producer: it must not be shared
+ * between threads without external synchronization.
+*/
+class AsyncWriter : public std::ostream
+{
+public:
+    /**
+     * Constructor for AsyncWriter.
+     * @param path of the output file (truncated if it exists).
+     * @param size of each buffer in bytes (default 4 MiB).
+     * @param depth the maximum number of full buffers waiting to be written
+     * (default 4).
+    */
+    AsyncWriter(const std::string & path, size_t size = 1 << 22, size_t depth = 4)
+        : std::ostream(nullptr), buffer(path, size, depth)
+    {
+        rdbuf(&buffer);
+    }
+
+    ~AsyncWriter() { buffer.close(); }
+
+    /**
+     * Writes the pending output and closes the file (see AsyncBuffer).
+     * @return none.
+    */
+    void close()
+    {
+        if(!buffer.close())
+            setstate(std::ios_base::badbit);
+    }
+
+private:
+    AsyncBuffer buffer;
+};
+#endif
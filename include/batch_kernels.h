@@ -0,0 +1,381 @@
+/**
+ * @file batch_kernels.h
+ * @brief Header file defining batch (structure-of-arrays) kernels for
+ * particle kinematics.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef BATCH_KERNELS_H
+#define BATCH_KERNELS_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "record_traits.h"
+#include "variables.h"
+
+/**
+ * Kernels operating on contiguous arrays of particle momenta/directions. The
+ * inputs are single precision (as stored in the CAF) and every kernel widens
+ * them to double precision before any arithmetic. The AVX2 path (compiled
+ * when __AVX2__ is defined) processes four particles at a time using only
+ * IEEE operations (multiply, add, divide, sqrt). The kernels are compiled
+ * with floating-point contraction disabled (see the pragmas below), since
+ * GCC and clang otherwise fuse the multiply-adds into FMA instructions when
+ * FMA is available (e.g. -march=native), so the AVX2 path is bit-identical
+ * to the scalar fallback. std::acos has no vector counterpart and is always
+ * applied element-wise.
+ *
+ * The scalar variables in variables.h/numu_variables.h evaluate some of the
+ * same expressions in single precision (the SRProxy accessors convert to
+ * float). The batch momenta and cosines agree with them to within 2^-21
+ * (relative for the momenta, absolute for the cosines, i.e. a few
+ * single-precision ulps). Angles are std::acos of those cosines: away from
+ * cos = +/-1 they agree to ~1e-6 rad, but close to +/-1 acos amplifies the
+ * single-precision rounding of the scalar path and the difference can reach
+ * a few 1e-4 rad, always below 1e-3 rad (the batch value is the more
+ * accurate). The benchmark checks
+ * these tolerances on synthetic spills (selection_benchmark --check).
+*/
+#if defined(__clang__)
+#pragma float_control(push)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+namespace kernels
+{
+    /**
+     * Computes the hypotenuse sqrt(a^2 + b^2) of each pair of elements.
+     * @param a the first component.
+     * @param b the second component.
+     * @param out the output array.
+     * @param n the number of elements.
+     * @return none.
+    */
+    inline void hypot(const float * a, const float * b, double * out, size_t n)
+    {
+        size_t i(0);
+#ifdef __AVX2__
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256d x(_mm256_cvtps_pd(_mm_loadu_ps(a + i)));
+            __m256d y(_mm256_cvtps_pd(_mm_loadu_ps(b + i)));
+            _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y))));
+        }
+#endif
+        for(; i < n; ++i)
+        {
+            double x(a[i]), y(b[i]);
+            double xx(x * x), yy(y * y);
+            out[i] = std::sqrt(xx + yy);
+        }
+    }
+
+    /**
+     * Computes c / sqrt(a^2 + b^2) for each triplet of elements.
+     * @param c the numerator.
+     * @param a the first component of the normalization.
+     * @param b the second component of the normalization.
+     * @param out the output array.
+     * @param n the number of elements.
+     * @return none.
+    */
+    inline void normalized(const float * c, const float * a, const float * b, double * out, size_t n)
+    {
+        size_t i(0);
+#ifdef __AVX2__
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256d x(_mm256_cvtps_pd(_mm_loadu_ps(a + i)));
+            __m256d y(_mm256_cvtps_pd(_mm_loadu_ps(b + i)));
+            __m256d z(_mm256_cvtps_pd(_mm_loadu_ps(c + i)));
+            _mm256_storeu_pd(out + i, _mm256_div_pd(z, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)))));
+        }
+#endif
+        for(; i < n; ++i)
+        {
+            double x(a[i]), y(b[i]), z(c[i]);
+            double xx(x * x), yy(y * y);
+            out[i] = z / std::sqrt(xx + yy);
+        }
+    }
+
+    /**
+     * Computes the dot product of each pair of 3-vectors.
+     * @param ax the x-component of the first vector.
+     * @param ay the y-component of the first vector.
+     * @param az the z-component of the first vector.
+     * @param bx the x-component of the second vector.
+     * @param by the y-component of the second vector.
+     * @param bz the z-component of the second vector.
+     * @param out the output array.
+     * @param n the number of elements.
+     * @return none.
+    */
+    inline void dot(const float * ax, const float * ay, const float * az,
+                    const float * bx, const float * by, const float * bz,
+                    double * out, size_t n)
+    {
+        size_t i(0);
+#ifdef __AVX2__
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256d x(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(ax + i)), _mm256_cvtps_pd(_mm_loadu_ps(bx + i))));
+            __m256d y(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(ay + i)), _mm256_cvtps_pd(_mm_loadu_ps(by + i))));
+            __m256d z(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(az + i)), _mm256_cvtps_pd(_mm_loadu_ps(bz + i))));
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_add_pd(x, y), z));
+        }
+#endif
+        for(; i < n; ++i)
+        {
+            double x(double(ax[i]) * double(bx[i]));
+            double y(double(ay[i]) * double(by[i]));
+            double z(double(az[i]) * double(bz[i]));
+            out[i] = (x + y) + z;
+        }
+    }
+
+    /**
+     * Applies std::acos element-wise (in place).
+     * @param inout the array to transform.
+     * @param n the number of elements.
+     * @return none.
+    */
+    inline void acos(double * inout, size_t n)
+    {
+        for(size_t i(0); i < n; ++i)
+            inout[i] = std::acos(inout[i]);
+    }
+
+    /**
+     * Computes the transverse momentum of each particle.
+     * @param px the x-component of the momentum.
+     * @param py the y-component of the momentum.
+     * @param out the output array.
+     * @param n the number of particles.
+     * @return none.
+    */
+    inline void transverse_momentum(const float * px, const float * py, double * out, size_t n) { hypot(px, py, out, n); }
+
+    /**
+     * Computes the polar angle (w.r.t the z-axis) of each particle.
+     * @param dz the z-component of the direction.
+     * @param out the output array.
+     * @param n the number of particles.
+     * @return none.
+    */
+    inline void polar_angle(const float * dz, double * out, size_t n)
+    {
+        for(size_t i(0); i < n; ++i)
+            out[i] = std::acos(double(dz[i]));
+    }
+
+    /**
+     * Computes the azimuthal angle (w.r.t the z-axis) of each particle.
+     * @param dx the x-component of the direction.
+     * @param dy the y-component of the direction.
+     * @param out the output array.
+     * @param n the number of particles.
+     * @return none.
+    */
+    inline void azimuthal_angle(const float * dx, const float * dy, double * out, size_t n)
+    {
+        normalized(dx, dx, dy, out, n);
+        acos(out, n);
+    }
+
+    /**
+     * Computes the cosine of the track angle within the XZ plane of each
+     * particle.
+     * @param dx the x-component of the direction.
+     * @param dz the z-component of the direction.
+     * @param out the output array.
+     * @param n the number of particles.
+     * @return none.
+    */
+    inline void cosine_theta_xz(const float * dx, const float * dz, double * out, size_t n) { normalized(dz, dx, dz, out, n); }
+
+    /**
+     * Computes the cosine of the opening angle between each pair of
+     * directions.
+     * @param ax the x-component of the first direction.
+     * @param ay the y-component of the first direction.
+     * @param az the z-component of the first direction.
+     * @param bx the x-component of the second direction.
+     * @param by the y-component of the second direction.
+     * @param bz the z-component of the second direction.
+     * @param out the output array.
+     * @param n the number of pairs.
+     * @return none.
+    */
+    inline void cosine_opening_angle(const float * ax, const float * ay, const float * az,
+                                     const float * bx, const float * by, const float * bz,
+                                     double * out, size_t n)
+    {
+        dot(ax, ay, az, bx, by, bz, out, n);
+    }
+}
+#if defined(__clang__)
+#pragma float_control(pop)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+/**
+ * Structure-of-arrays buffer holding the momenta and directions of all reco
+ * (or all true) particles of a spill. Particles are stored in spill order,
+ * and the particles of interaction k occupy [offsets[k], offsets[k+1]). For
+ * true particles the truth_momentum and truth_start_dir attributes are used,
+ * matching numu_variables.h. The position of the leading muon and proton of
+ * each interaction (see vars::leading_particle_index()) is recorded when the
+ * particles are gathered. The kinematic columns are computed on first
+ * request and then reused by every variable on the same spill.
+*/
+struct ParticleBatch
+{
+    /**
+     * The kinematic columns available from the batch. The particle columns
+     * hold one value per particle (in spill order); kCosineOpeningAngle holds
+     * one value per interaction, the cosine of the opening angle between its
+     * leading muon and leading proton (0 for interactions without particles).
+    */
+    enum Column { kTransverseMomentum, kPolarAngle, kAzimuthalAngle, kCosineThetaXZ, kCosineOpeningAngle, kColumns };
+
+    /**
+     * The element of an interaction a column is read at (see value()).
+    */
+    enum Element { kLeadingMuon, kLeadingProton, kLeadingPair };
+
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> leading_muon, leading_proton;
+    std::vector<float> px, py, pz;
+    std::vector<float> dx, dy, dz;
+    std::vector<float> scratch[6];
+    std::vector<double> columns[kColumns];
+    uint32_t computed = 0;
+    bool gathered = false;
+
+    /**
+     * Invalidates the batch for a new spill. The storage keeps its capacity.
+     * @return none.
+    */
+    void reset()
+    {
+        gathered = false;
+        computed = 0;
+    }
+
+    /**
+     * Gathers the momenta and directions of the particles of a set of
+     * interactions.
+     * @tparam V the type of the interaction vector (sr->dlp or sr->dlp_true).
+     * @param interactions the interactions to gather.
+     * @return none.
+    */
+    template<class V>
+        void gather(const V & interactions)
+        {
+            offsets.assign(1, 0);
+            leading_muon.clear(); leading_proton.clear();
+            px.clear(); py.clear(); pz.clear();
+            dx.clear(); dy.clear(); dz.clear();
+            for(auto const& i : interactions)
+            {
+                leading_muon.push_back(px.size() + vars::leading_particle_index(i, 2));
+                leading_proton.push_back(px.size() + vars::leading_particle_index(i, 4));
+                for(auto const& p : i.particles)
+                {
+                    using P = std::decay_t<decltype(p)>;
+                    if constexpr (is_truth_v<P>)
+                    {
+                        px.push_back(p.truth_momentum[0]); py.push_back(p.truth_momentum[1]); pz.push_back(p.truth_momentum[2]);
+                        dx.push_back(p.truth_start_dir[0]); dy.push_back(p.truth_start_dir[1]); dz.push_back(p.truth_start_dir[2]);
+                    }
+                    else
+                    {
+                        px.push_back(p.momentum[0]); py.push_back(p.momentum[1]); pz.push_back(p.momentum[2]);
+                        dx.push_back(p.start_dir[0]); dy.push_back(p.start_dir[1]); dz.push_back(p.start_dir[2]);
+                    }
+                }
+                offsets.push_back(px.size());
+            }
+            gathered = true;
+        }
+
+    /**
+     * Retrieves a kinematic column, computing it if needed.
+     * @param c the column to retrieve.
+     * @return the values of the column (one per particle, in spill order, or
+     * one per interaction for kCosineOpeningAngle).
+    */
+    const std::vector<double> & column(Column c)
+    {
+        std::vector<double> & out(columns[c]);
+        if(computed & (1u << c)) return out;
+        size_t n(c == kCosineOpeningAngle ? leading_muon.size() : px.size());
+        out.resize(n);
+        switch(c)
+        {
+        case kTransverseMomentum:
+            kernels::transverse_momentum(px.data(), py.data(), out.data(), n);
+            break;
+        case kPolarAngle:
+            kernels::polar_angle(dz.data(), out.data(), n);
+            break;
+        case kAzimuthalAngle:
+            kernels::azimuthal_angle(dx.data(), dy.data(), out.data(), n);
+            break;
+        case kCosineThetaXZ:
+            kernels::cosine_theta_xz(dx.data(), dz.data(), out.data(), n);
+            break;
+        case kCosineOpeningAngle:
+            for(std::vector<float> & v : scratch)
+                v.resize(n);
+            for(size_t k(0); k < n; ++k)
+            {
+                if(offsets[k] == offsets[k + 1])
+                {
+                    for(std::vector<float> & v : scratch)
+                        v[k] = 0;
+                    continue;
+                }
+                scratch[0][k] = dx[leading_muon[k]]; scratch[1][k] = dy[leading_muon[k]]; scratch[2][k] = dz[leading_muon[k]];
+                scratch[3][k] = dx[leading_proton[k]]; scratch[4][k] = dy[leading_proton[k]]; scratch[5][k] = dz[leading_proton[k]];
+            }
+            kernels::cosine_opening_angle(scratch[0].data(), scratch[1].data(), scratch[2].data(),
+                                          scratch[3].data(), scratch[4].data(), scratch[5].data(), out.data(), n);
+            break;
+        default:
+            break;
+        }
+        computed |= 1u << c;
+        return out;
+    }
+
+    /**
+     * Reads a kinematic column at an element of an interaction: the leading
+     * muon or proton for the particle columns, the pair of both for
+     * kCosineOpeningAngle.
+     * @param c the column to read.
+     * @param k the index of the interaction.
+     * @param e the element of the interaction.
+     * @return the value of the column.
+    */
+    double value(Column c, size_t k, Element e)
+    {
+        const std::vector<double> & v(column(c));
+        if(e == kLeadingPair)
+            return v[k];
+        return v[e == kLeadingMuon ? leading_muon[k] : leading_proton[k]];
+    }
+};
+#endif
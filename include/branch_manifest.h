@@ -0,0 +1,216 @@
+/**
+ * @file branch_manifest.h
+ * @brief Header file defining a SpectrumLoader that restricts the branches
+ * read from the flat CAF files to an explicit manifest.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef BRANCH_MANIFEST_H
+#define BRANCH_MANIFEST_H
+
+#include "sbnana/CAFAna/Core/SpectrumLoader.h"
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+
+#include <set>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "spill_entry.h"
+
+/**
+ * SpectrumLoader that reads only the branches listed in a manifest file,
+ * selected by setting SPEC_MANIFEST to the path of the manifest. The
+ * manifest holds one branch name per line and is produced by a training
+ * run (SPEC_MANIFEST_TRAIN=1), in which the loader reads the input as usual
+ * and adds every branch accessed through the SRProxy (i.e. by the cuts and
+ * variables of the selection) to the manifest. Concurrent training runs,
+ * e.g. the workers of a SpecContainer, add to the same manifest.
+ *
+ * On production runs all other branches of recTree are disabled and the
+ * TTreeCache is configured for exactly the branches of the manifest. A
+ * branch accessed that is missing from the manifest (e.g. one only read by
+ * rare spills not seen in training) is an error, since the values read from
+ * a disabled branch are invalid; the manifest must then be trained again.
+ *
+ * In both modes the number of bytes read per spill is printed at the end of
+ * the run. The training runs record the bytes and spills they read in the
+ * manifest so that the two can be compared. The loader also advances the
+ * SpillEntry counter that identifies the spill for the per-spill caches.
+*/
+class ManifestLoader : public ana::SpectrumLoader
+{
+public:
+    /**
+     * Constructor for ManifestLoader.
+     * @param in_name is the name of the input CAF file(s).
+    */
+    ManifestLoader(const std::string & in_name)
+    : ana::SpectrumLoader(in_name),
+      training(false),
+      training_bytes(0),
+      bytes(0),
+      spills(0)
+    {
+        const char * path(std::getenv("SPEC_MANIFEST"));
+        const char * train(std::getenv("SPEC_MANIFEST_TRAIN"));
+        if(path == nullptr || *path == '\0')
+            return;
+        manifest = path;
+        training = train != nullptr && std::string(train) != "0";
+        if(!training)
+        {
+            Long64_t read_bytes(0), read_spills(0);
+            read(manifest, branches, read_bytes, read_spills);
+            training_bytes = read_spills > 0 ? double(read_bytes) / read_spills : 0;
+            if(branches.empty())
+                throw std::runtime_error("ManifestLoader: no branches in manifest " + manifest);
+        }
+    }
+
+    /**
+     * Runs the loader. In training mode the branches accessed are added to
+     * the manifest afterwards.
+     * @return none.
+    */
+    void Go() override
+    {
+        caf::SRBranchRegistry::clear();
+        ana::SpectrumLoader::Go();
+        if(manifest.empty())
+            return;
+        double per_spill(spills > 0 ? double(bytes) / spills : 0);
+        if(training)
+        {
+            write(caf::SRBranchRegistry::GetBranches());
+            std::cout << "ManifestLoader: " << caf::SRBranchRegistry::GetBranches().size() << " branches recorded to "
+                      << manifest << ", " << per_spill << " bytes read per spill" << std::endl;
+        }
+        else
+        {
+            std::cout << "ManifestLoader: " << branches.size() << " branches from " << manifest << ", "
+                      << per_spill << " bytes read per spill (" << training_bytes << " without the manifest)" << std::endl;
+        }
+    }
+
+protected:
+    /**
+     * Processes an input file, restricting the branches read on production
+     * runs and counting the bytes read.
+     * @param f is the input file.
+     * @param prog is the progress bar of the loader.
+     * @return none.
+    */
+    void HandleFile(TFile * f, ana::Progress * prog=0) override
+    {
+        TTree * tree(f->Get<TTree>("recTree"));
+        if(tree != nullptr && !training && !branches.empty())
+        {
+            tree->SetBranchStatus("*", 0);
+            for(const std::string & b : branches)
+                tree->SetBranchStatus(b.c_str(), 1);
+            tree->SetCacheSize(kCacheBytes);
+            for(const std::string & b : branches)
+                tree->AddBranchToCache(b.c_str(), false);
+            tree->StopCacheLearningPhase();
+        }
+        Long64_t start(f->GetBytesRead());
+        ana::SpectrumLoader::HandleFile(f, prog);
+        bytes += f->GetBytesRead() - start;
+        if(tree != nullptr)
+            spills += tree->GetEntries();
+
+        if(!training && !branches.empty())
+        {
+            for(const std::string & b : caf::SRBranchRegistry::GetBranches())
+            {
+                if(branches.count(b) == 0)
+                    throw std::runtime_error("ManifestLoader: branch " + b + " is not in manifest " + manifest
+                                             + " (train it again with SPEC_MANIFEST_TRAIN=1)");
+            }
+        }
+    }
+
+    /**
+     * Processes a spill, advancing the SpillEntry counter first so that the
+     * per-spill caches of the selection are invalidated.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return none.
+    */
+    void HandleRecord(caf::SRSpillProxy * sr) override
+    {
+        SpillEntry::advance();
+        ana::SpectrumLoader::HandleRecord(sr);
+    }
+
+private:
+    /**
+     * Reads a manifest file.
+     * @param path is the name of the manifest file.
+     * @param names is the set the branch names are added to.
+     * @param read_bytes is incremented by the bytes read in training.
+     * @param read_spills is incremented by the spills read in training.
+     * @return none.
+    */
+    static void read(const std::string & path, std::set<std::string> & names, Long64_t & read_bytes, Long64_t & read_spills)
+    {
+        std::ifstream input(path);
+        std::string line;
+        while(std::getline(input, line))
+        {
+            if(line.compare(0, kBytesTag.size(), kBytesTag) == 0)
+            {
+                size_t end;
+                read_bytes += std::stoll(line.substr(kBytesTag.size()), &end);
+                read_spills += std::stoll(line.substr(kBytesTag.size() + end));
+            }
+            else if(!line.empty() && line[0] != '#')
+                names.insert(line);
+        }
+    }
+
+    /**
+     * Adds branches to the manifest file. The file is locked while it is
+     * updated and replaced atomically, so training runs may share it.
+     * @param recorded is the set of branches accessed.
+     * @return none.
+    */
+    void write(const std::set<std::string> & recorded) const
+    {
+        int lock(open((manifest + ".lock").c_str(), O_CREAT | O_RDWR, 0644));
+        if(lock < 0 || flock(lock, LOCK_EX) != 0)
+            throw std::runtime_error("ManifestLoader: unable to lock manifest " + manifest);
+        std::set<std::string> names(recorded);
+        Long64_t read_bytes(bytes), read_spills(spills);
+        read(manifest, names, read_bytes, read_spills);
+        std::string temporary(manifest + ".tmp" + std::to_string(getpid()));
+        std::ofstream output(temporary, std::ios::trunc);
+        output << kBytesTag << read_bytes << " " << read_spills << "\n";
+        for(const std::string & b : names)
+            output << b << "\n";
+        output.close();
+        std::rename(temporary.c_str(), manifest.c_str());
+        flock(lock, LOCK_UN);
+        close(lock);
+    }
+
+    static constexpr Long64_t kCacheBytes = 64 << 20;
+    static inline const std::string kBytesTag = "# bytes and spills read: ";
+    std::string manifest;
+    bool training;
+    std::set<std::string> branches;
+    double training_bytes;
+    Long64_t bytes;
+    Long64_t spills;
+};
+#endif
@@ -10,20 +10,47 @@
 #include "sbnana/CAFAna/Core/Spectrum.h"
 #include "sbnana/CAFAna/Core/Binning.h"
 
+#include <string>
+#include <vector>
+#include <thread>
+#include <numeric>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+
+#include <unistd.h>
+
 #include "TFile.h"
 #include "TH1D.h"
 #include "TH2D.h"
+#include "TVectorD.h"
+#include "TObjString.h"
+
+#include "instrumentation.h"
+#include "branch_manifest.h"
+#include "file_list.h"
+#include "output_sink.h"
+#include "worker_pool.h"
+#include "result_cache.h"
+#include "spectrum_manifest.h"
 
 /**
  * Container class for CAFAna Spectrum objects. Allows for easier
  * configuration of a set of CAFAna Spectrum, and handles the output of
- * the resulting histograms to a ROOT file.
+ * the resulting histograms to a ROOT file. The branches read from the
+ * input can be restricted to a manifest (see ManifestLoader).
 */
 struct SpecContainer
 {
-    ana::SpectrumLoader loader;
+    std::string input_name;
+    std::string output_name;
+    ManifestLoader loader;
     std::vector<const char *> names;
+    std::vector<std::string> keys;
     std::vector<ana::Spectrum*> spectra;
+    std::vector<std::function<void(SpecContainer &)>> definitions;
     TFile output_file;
     float override_pot;
     float target_pot;
@@ -31,11 +58,17 @@ struct SpecContainer
     /**
      * Constructor for SpecContainer.
      * @param in_name is the name of the input CAF file.
-     * @param out_name is the name of the output ROOT file.
+     * @param out_name is the name of the output ROOT file (the job index is
+     * inserted, see sink_path()).
+     * @param job is the job index inserted into the name of the output file
+     * (default: SELECTION_JOB).
     */
-    SpecContainer(const char * in_name, const char * out_name, float opot=-1, float tpot=-1)
-    : loader(in_name),
-      output_file(out_name, "recreate"),
+    SpecContainer(const char * in_name, const char * out_name, float opot=-1, float tpot=-1,
+                  const std::string & job=job_index())
+    : input_name(in_name),
+      output_name(out_name),
+      loader(in_name),
+      output_file(sink_path(out_name, 0, job).c_str(), "recreate"),
       override_pot(opot),
       target_pot(tpot) { }
     
@@ -44,12 +77,18 @@ struct SpecContainer
      * @param n is the name of the spectrum.
      * @param b is the Binning of the spectrum.
      * @param v is the variable defining the spectrum
+     * @param cut is the spill cut of the spectrum (default: none).
+     * @param definition identifies v and cut when they are chosen at runtime
+     * (see SpectrumManifest), for the keys of the result cache.
      * @return none.
     */
-    void add_spectrum1d(const char * n, const ana::Binning b, const ana::SpillMultiVar v)
+    void add_spectrum1d(const char * n, const ana::Binning b, const ana::SpillMultiVar v,
+                        const ana::SpillCut cut=ana::kNoSpillCut, const std::string & definition="")
     {
+        definitions.push_back([=](SpecContainer & c) { c.add_spectrum1d(n, b, v, cut, definition); });
         names.push_back(n);
-        spectra.push_back(new ana::Spectrum(n, b, loader, v, ana::kNoSpillCut));
+        keys.push_back(ResultCache::spectrum_key(n, {b.Edges()}, definition));
+        spectra.push_back(new ana::Spectrum(n, b, loader, v, cut));
         if(override_pot != -1) spectra.back()->OverridePOT(override_pot);
     }
 
@@ -60,23 +99,68 @@ struct SpecContainer
      * @param b1 is the second set of Binnings.
      * @param v0 is the first variable.
      * @param v1 is the second variable.
+     * @param cut is the spill cut of the spectrum (default: none).
+     * @param definition identifies v0, v1, and cut when they are chosen at
+     * runtime (see SpectrumManifest), for the keys of the result cache.
      * @return none.
     */
     void add_spectrum2d(const char * n, const ana::Binning b0, const ana::Binning b1,
-                        const ana::SpillMultiVar v0, const ana::SpillMultiVar v1)
+                        const ana::SpillMultiVar v0, const ana::SpillMultiVar v1,
+                        const ana::SpillCut cut=ana::kNoSpillCut, const std::string & definition="")
     {
+        definitions.push_back([=](SpecContainer & c) { c.add_spectrum2d(n, b0, b1, v0, v1, cut, definition); });
         names.push_back(n);
-        spectra.push_back(new ana::Spectrum(n, loader, b0, v0, b1, v1, ana::kNoSpillCut));
+        keys.push_back(ResultCache::spectrum_key(n, {b0.Edges(), b1.Edges()}, definition));
+        spectra.push_back(new ana::Spectrum(n, loader, b0, v0, b1, v1, cut));
         if(override_pot != -1) spectra.back()->OverridePOT(override_pot);
     }
 
     /**
-     * Runs the selection and fills each spectrum in the container.
+     * Adds the spectra of a manifest file to the container.
+     * @param path is the name of the TOML manifest (see SpectrumManifest).
+     * @return none.
+    */
+    void add_manifest(const std::string & path)
+    {
+        SpectrumManifest(path).add_spectra(*this);
+    }
+
+    /**
+     * Runs the selection and fills each spectrum in the container. If the
+     * instrumentation is compiled in (see instrumentation.h), a report of the
+     * cuts and variables is printed at the end of the run and written as JSON
+     * next to the output file (with the ".root" suffix replaced by
+     * "_instrumentation.json"). With worker processes, the report sums the
+     * instrumentation of every worker (files loaded from the result cache
+     * are not evaluated and thus not included).
+     *
+     * With more than one worker, or with checkpointing, the input files
+     * matching the input name are processed one by one in forked worker
+     * processes (see run_files()). If SPEC_RESUME is set, a run that was
+     * interrupted resumes from its last checkpoint. If SPEC_CACHE is set, the
+     * input files are always processed one by one, and the results of files
+     * processed before with the same selection code are loaded from the
+     * cache (see ResultCache).
+     * @param workers is the maximum number of concurrent workers (default:
+     * 1, i.e. the input is processed in the current process).
+     * @param checkpoint is the number of input files after which a
+     * checkpoint is written (default: 0, no checkpoints).
      * @return none.
     */
-    void run()
+    void run(size_t workers=1, size_t checkpoint=0)
     {
+        ResultCache cache;
+        if(workers > 1 || checkpoint > 0 || cache.enabled())
+        {
+            std::vector<std::string> files(glob_files(input_name));
+            if(files.size() > 1 || (cache.enabled() && !files.empty()))
+            {
+                run_files(files, workers, checkpoint, cache);
+                return;
+            }
+        }
         loader.Go();
+        report_instrumentation();
         for(size_t i(0); i < spectra.size(); ++i)
             output_file.WriteObject(spectra[i]->ToTHX(target_pot != -1 ? target_pot : 1), names[i]);
         output_file.Close();
@@ -91,5 +175,417 @@ struct SpecContainer
         for(ana::Spectrum * s : spectra)
             delete s;
     }
+
+private:
+    /**
+     * Processes the input files in parallel and merges the results. Each
+     * file is processed by a worker process with its own SpectrumLoader and
+     * spectra, which are written unscaled together with their POT to a
+     * partial output file. The partial spectra are summed in file order as
+     * the files complete, the POT is summed, and the sums are scaled to the
+     * target POT at the end (relative to the override POT, if set, which is
+     * applied only here and not in the workers). The livetime of the files
+     * is not summed; the spectra are normalized by POT only, as in a run in
+     * the current process. The CSV logs and row
+     * trees of the workers are appended in file order at the end (see
+     * merge_worker_outputs()). The outputs therefore do not depend on the
+     * number of workers.
+     *
+     * Every time at least the given number of files has been added to the
+     * sums, the sums, the POT, and the list of the files added are written
+     * to a checkpoint file next to the output (".checkpoint" appended). If
+     * SPEC_RESUME is set, the sums are restored from the checkpoint and the
+     * files already added are skipped; their logs and row trees are still on
+     * disk and are merged as usual.
+     *
+     * Files found in the result cache are not processed; their results are
+     * restored from the cache instead. The results of the files processed
+     * are stored in the cache.
+     * @param files is the list of input files.
+     * @param workers is the maximum number of concurrent workers.
+     * @param checkpoint is the number of files between checkpoints (0 for
+     * no checkpoints).
+     * @param cache is the result cache.
+     * @return none.
+    */
+    void run_files(const std::vector<std::string> & files, size_t workers, size_t checkpoint, const ResultCache & cache)
+    {
+        std::string checkpoint_path(sink_path(output_name) + ".checkpoint");
+        sums.assign(spectra.size(), nullptr);
+        exposure.assign(spectra.size(), 0);
+        const char * resume(std::getenv("SPEC_RESUME"));
+        size_t added(resume != nullptr && std::string(resume) != "0" ? load_checkpoint(checkpoint_path, files) : 0);
+        size_t last(added);
+
+        std::vector<bool> complete(files.size(), false);
+        auto finish = [&](size_t k, bool success)
+        {
+            complete[k] = success;
+            while(added < files.size() && complete[added])
+                add_partial(added++);
+            if(checkpoint > 0 && added - last >= checkpoint)
+            {
+                save_checkpoint(checkpoint_path, files, added);
+                last = added;
+            }
+        };
+
+        std::vector<size_t> pending;
+        size_t loaded(0);
+        for(size_t k(added); k < files.size(); ++k)
+        {
+            if(cache.enabled() && cache.load(files[k], names, keys, partial_path(k), worker_job(k)))
+            {
+                finish(k, true);
+                ++loaded;
+            }
+            else
+                pending.push_back(k);
+        }
+        if(cache.enabled())
+            std::cout << "SpecContainer: " << loaded << " of " << files.size() << " files loaded from the cache" << std::endl;
+
+        run_workers(pending, workers, [&](size_t k)
+        {
+#ifdef INSTRUMENTATION
+            Instrumentation::instance().reset();
+#endif
+            SpecContainer part(files[k].c_str(), output_name.c_str());
+            for(const std::function<void(SpecContainer &)> & d : definitions)
+                d(part);
+            part.loader.Go();
+            TVectorD pot(part.spectra.size());
+            for(size_t i(0); i < part.spectra.size(); ++i)
+            {
+                // The partial spectra hold the unscaled counts. A file without
+                // POT (e.g. cosmics or off-beam data, normalized by
+                // override_pot in the parent) is written through unscaled.
+                pot[i] = part.spectra[i]->POT();
+                if(pot[i] <= 0)
+                {
+                    pot[i] = 0;
+                    part.spectra[i]->OverridePOT(1);
+                }
+                part.output_file.WriteObject(part.spectra[i]->ToTHX(pot[i] > 0 ? pot[i] : 1), part.names[i]);
+            }
+            part.output_file.WriteObject(&pot, "exposure");
+            part.output_file.Close();
+#ifdef INSTRUMENTATION
+            Instrumentation::instance().write_json(instrumentation_path(part.output_file.GetName()));
+#endif
+        },
+        [&](size_t k, bool success)
+        {
+#ifdef INSTRUMENTATION
+            std::string instrumentation(instrumentation_path(partial_path(k)));
+            if(success)
+                Instrumentation::instance().merge_json(instrumentation);
+            std::remove(instrumentation.c_str());
+#endif
+            if(success && cache.enabled())
+                cache.store(files[k], names, keys, partial_path(k), worker_job(k));
+            finish(k, success);
+        });
+        if(added < files.size())
+        {
+            if(checkpoint > 0 && added > last)
+                save_checkpoint(checkpoint_path, files, added);
+            throw std::runtime_error("SpecContainer: processing of " + files[added] + " failed");
+        }
+
+        for(size_t k(0); k < files.size(); ++k)
+            merge_worker_outputs(k);
+        report_instrumentation();
+        for(size_t i(0); i < spectra.size(); ++i)
+        {
+            double total(override_pot != -1 ? override_pot : exposure[i]);
+            if(total > 0)
+                sums[i]->Scale((target_pot != -1 ? target_pot : 1) / total);
+            output_file.WriteObject(sums[i], names[i]);
+            delete sums[i];
+        }
+        output_file.Close();
+        std::remove(checkpoint_path.c_str());
+    }
+
+    /**
+     * Prints the report of the instrumentation, if it is compiled in (see
+     * instrumentation.h), and writes it as JSON next to the output file
+     * (with the ".root" suffix replaced by "_instrumentation.json").
+     * @return none.
+    */
+    void report_instrumentation()
+    {
+#ifdef INSTRUMENTATION
+        Instrumentation::instance().report(std::cout);
+        Instrumentation::instance().write_json(instrumentation_path(output_file.GetName()));
+#endif
+    }
+
+    /**
+     * Builds the name of the instrumentation report of an output file.
+     * @param output is the name of the output file.
+     * @return the name with the ".root" suffix replaced by
+     * "_instrumentation.json".
+    */
+    static std::string instrumentation_path(std::string output)
+    {
+        if(output.size() > 5 && output.compare(output.size() - 5, 5, ".root") == 0)
+            output.erase(output.size() - 5);
+        return output + "_instrumentation.json";
+    }
+
+    /**
+     * Builds the name of the partial spectra file of an input file.
+     * @param k is the index of the input file.
+     * @return the name of the partial spectra file.
+    */
+    std::string partial_path(size_t k) const
+    {
+        return sink_path(output_name, 0, worker_job(k));
+    }
+
+    /**
+     * Adds the partial spectra and POT of an input file to the sums and
+     * removes the partial output file.
+     * @param k is the index of the input file.
+     * @return none.
+    */
+    void add_partial(size_t k)
+    {
+        std::string path(partial_path(k));
+        TFile part(path.c_str(), "READ");
+        TVectorD * pot(part.Get<TVectorD>("exposure"));
+        for(size_t i(0); i < spectra.size(); ++i)
+        {
+            TH1 * h(part.Get<TH1>(names[i]));
+            h->SetDirectory(nullptr);
+            exposure[i] += (*pot)[i];
+            if(sums[i] == nullptr)
+                sums[i] = h;
+            else
+            {
+                sums[i]->Add(h);
+                delete h;
+            }
+        }
+        delete pot;
+        part.Close();
+        std::remove(path.c_str());
+    }
+
+    /**
+     * Writes the sums, the POT, and the list of the files added to the
+     * checkpoint file. The file is replaced atomically, so an interruption
+     * leaves the previous checkpoint intact.
+     * @param path is the name of the checkpoint file.
+     * @param files is the list of input files.
+     * @param added is the number of input files added to the sums.
+     * @return none.
+    */
+    void save_checkpoint(const std::string & path, const std::vector<std::string> & files, size_t added)
+    {
+        std::string list;
+        for(size_t k(0); k < added; ++k)
+            list += files[k] + "\n";
+        TObjString completed(list.c_str());
+        TVectorD pot(exposure.size());
+        for(size_t i(0); i < exposure.size(); ++i)
+            pot[i] = exposure[i];
+
+        std::string temporary(path + ".tmp");
+        TFile output(temporary.c_str(), "recreate");
+        for(size_t i(0); i < sums.size(); ++i)
+            output.WriteObject(sums[i], names[i]);
+        output.WriteObject(&pot, "exposure");
+        output.WriteObject(&completed, "files");
+        output.Close();
+        std::rename(temporary.c_str(), path.c_str());
+        std::cout << "SpecContainer: checkpoint after " << added << " of " << files.size() << " files" << std::endl;
+    }
+
+    /**
+     * Restores the sums and the POT from the checkpoint file.
+     * @param path is the name of the checkpoint file.
+     * @param files is the list of input files, of which the files listed in
+     * the checkpoint must be the first.
+     * @return the number of input files already added to the sums (0 if there
+     * is no checkpoint).
+    */
+    size_t load_checkpoint(const std::string & path, const std::vector<std::string> & files)
+    {
+        if(access(path.c_str(), R_OK) != 0)
+            return 0;
+        TFile input(path.c_str(), "READ");
+        TObjString * completed(input.Get<TObjString>("files"));
+        TVectorD * pot(input.Get<TVectorD>("exposure"));
+        if(completed == nullptr || pot == nullptr || pot->GetNrows() != int(spectra.size()))
+            throw std::runtime_error("SpecContainer: invalid checkpoint " + path);
+
+        std::string list(completed->GetName());
+        size_t added(0), begin(0), end;
+        while((end = list.find('\n', begin)) != std::string::npos)
+        {
+            if(added >= files.size() || list.compare(begin, end - begin, files[added]) != 0)
+                throw std::runtime_error("SpecContainer: the input files do not match the checkpoint " + path);
+            ++added;
+            begin = end + 1;
+        }
+        for(size_t i(0); i < spectra.size(); ++i)
+        {
+            sums[i] = input.Get<TH1>(names[i]);
+            if(sums[i] == nullptr)
+                throw std::runtime_error("SpecContainer: " + std::string(names[i]) + " missing from checkpoint " + path);
+            sums[i]->SetDirectory(nullptr);
+            exposure[i] = (*pot)[i];
+        }
+        delete completed;
+        delete pot;
+        input.Close();
+        std::cout << "SpecContainer: resuming after " << added << " of " << files.size() << " files" << std::endl;
+        return added;
+    }
+
+    std::vector<TH1 *> sums;
+    std::vector<double> exposure;
+};
+
+/**
+ * Batch of samples (e.g. the CV and detector variation samples) processed
+ * with a common set of spectra. The spectra are defined once on the batch;
+ * each sample is then run in its own worker process (see run_workers())
+ * with its own SpecContainer (and SpectrumLoader). The spectra are written
+ * to the output file given for each sample, and the CSV logs and row trees
+ * of sample k are written with the job index worker_job(k) (see
+ * sink_path()), e.g. output_mc_crtpmt.job2.log for sample 2. They are kept
+ * per sample rather than merged (the samples are distinct selections), and
+ * the files of each sample are listed when the batch completes (see
+ * sample_outputs()).
+*/
+struct SpecBatch
+{
+    struct Sample
+    {
+        std::string in_name;
+        std::string out_name;
+        float override_pot;
+        float target_pot;
+    };
+
+    std::vector<Sample> samples;
+    std::vector<std::function<void(SpecContainer &)>> definitions;
+
+    /**
+     * Adds a sample to the batch.
+     * @param in_name is the name of the input CAF file(s).
+     * @param out_name is the name of the output ROOT file.
+     * @param opot is the POT override of the sample (-1 for none).
+     * @param tpot is the POT the spectra are scaled to (-1 for none).
+     * @return none.
+    */
+    void add_sample(const char * in_name, const char * out_name, float opot=-1, float tpot=-1)
+    {
+        samples.push_back({in_name, out_name, opot, tpot});
+    }
+
+    /**
+     * Adds a CAFAna Spectrum (1D) to the spectra of every sample.
+     * @param n is the name of the spectrum.
+     * @param b is the Binning of the spectrum.
+     * @param v is the variable defining the spectrum
+     * @param cut is the spill cut of the spectrum (default: none).
+     * @param definition identifies v and cut when they are chosen at runtime
+     * (see SpectrumManifest).
+     * @return none.
+    */
+    void add_spectrum1d(const char * n, const ana::Binning b, const ana::SpillMultiVar v,
+                        const ana::SpillCut cut=ana::kNoSpillCut, const std::string & definition="")
+    {
+        definitions.push_back([=](SpecContainer & c) { c.add_spectrum1d(n, b, v, cut, definition); });
+    }
+
+    /**
+     * Adds a CAFAna Spectrum (2D) to the spectra of every sample.
+     * @param n is the name of the spectrum.
+     * @param b0 is the first set of Binnings.
+     * @param b1 is the second set of Binnings.
+     * @param v0 is the first variable.
+     * @param v1 is the second variable.
+     * @param cut is the spill cut of the spectrum (default: none).
+     * @param definition identifies v0, v1, and cut when they are chosen at
+     * runtime (see SpectrumManifest).
+     * @return none.
+    */
+    void add_spectrum2d(const char * n, const ana::Binning b0, const ana::Binning b1,
+                        const ana::SpillMultiVar v0, const ana::SpillMultiVar v1,
+                        const ana::SpillCut cut=ana::kNoSpillCut, const std::string & definition="")
+    {
+        definitions.push_back([=](SpecContainer & c) { c.add_spectrum2d(n, b0, b1, v0, v1, cut, definition); });
+    }
+
+    /**
+     * Adds the spectra of a manifest file to the spectra of every sample.
+     * @param path is the name of the TOML manifest (see SpectrumManifest).
+     * @return none.
+    */
+    void add_manifest(const std::string & path)
+    {
+        SpectrumManifest(path).add_spectra(*this);
+    }
+
+    /**
+     * Lists the CSV logs and row trees written by a sample.
+     * @param k the index of the sample.
+     * @return the names of the files of the sample.
+    */
+    static std::vector<std::string> sample_outputs(size_t k)
+    {
+        std::vector<std::string> outputs;
+        for(WorkerSink * s : WorkerSink::registry())
+        {
+            for(size_t shard(0); ; ++shard)
+            {
+                std::string path(s->output(worker_job(k), shard));
+                if(path.empty() || access(path.c_str(), F_OK) != 0)
+                    break;
+                outputs.push_back(path);
+            }
+        }
+        return outputs;
+    }
+
+    /**
+     * Runs the selection over every sample, with at most the given number of
+     * samples processed concurrently. The output files of each sample are
+     * listed once the samples complete.
+     * @param workers is the maximum number of concurrent workers (default:
+     * the number of cores).
+     * @return the number of samples that failed.
+    */
+    size_t run(size_t workers=std::thread::hardware_concurrency())
+    {
+        std::string job(job_index());
+        std::vector<size_t> tasks(samples.size());
+        std::iota(tasks.begin(), tasks.end(), 0);
+        std::vector<bool> success(run_workers(tasks, workers, [&](size_t k)
+        {
+            const Sample & sample(samples[k]);
+            SpecContainer spectra(sample.in_name.c_str(), sample.out_name.c_str(), sample.override_pot, sample.target_pot, job);
+            for(const std::function<void(SpecContainer &)> & d : definitions)
+                d(spectra);
+            spectra.run();
+        }));
+        size_t failed(0);
+        for(size_t k(0); k < samples.size(); ++k)
+        {
+            std::cout << "SpecBatch: sample " << k << " (" << samples[k].out_name << ") "
+                      << (success[k] ? "done" : "failed");
+            for(const std::string & path : sample_outputs(k))
+                std::cout << ", " << path;
+            std::cout << std::endl;
+            failed += !success[k];
+        }
+        return failed;
+    }
 };
-#endif
\ No newline at end of file
+#endif
@@ -9,8 +9,10 @@
 #include <vector>
 #include <map>
 #include <iostream>
-#include <fstream>
+#include <cmath>
 
+#include "output_sink.h"
+#include "row_tree.h"
 #include "cuts.h"
 #include "variables.h"
 #include "numu_variables.h"
@@ -18,8 +20,36 @@
 #include "sbnana/CAFAna/Core/MultiVar.h"
 #include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
 
-std::ofstream output("output_mc_crtpmt.log");
-//std::ofstream output("output_tpcuntunedsigshape.log");
+ShardedWriter output("output_mc_crtpmt.log");
+//ShardedWriter output("output_tpcuntunedsigshape.log");
+
+/**
+ * Typed columnar output of the SIGNAL and SELECTED rows (one TTree each, see
+ * rows::kPairColumns). The file must be closed (output_rows.close()) once the
+ * spectra have been filled.
+*/
+RowFile output_rows("output_mc_crtpmt.root");
+RowTree & signal_rows(output_rows.add("SIGNAL", rows::kPairColumns));
+RowTree & selected_rows(output_rows.add("SELECTED", rows::kPairColumns));
+
+/**
+ * The selected candidates of each channel that pass the CRT-PMT veto and are
+ * within kTriggerWindow of the nominal trigger time, as read by
+ * read_selected() in the systematics code.
+*/
+const double kTriggerWindow = 11;
+RowTree & selected_1mu1p_rows(output_rows.add("selected_1mu1p", rows::kPairColumns));
+RowTree & selected_1muNp_rows(output_rows.add("selected_1muNp", rows::kPairColumns));
+RowTree & selected_1muX_rows(output_rows.add("selected_1muX", rows::kPairColumns));
+
+/**
+ * Optional list of all spills of the sample, as read by read_event_metadata()
+ * in the systematics code. Enabled by defining EVENTS_TREE (e.g. with
+ * -DEVENTS_TREE).
+*/
+#ifdef EVENTS_TREE
+RowTree & event_rows(output_rows.add("events", rows::kEventColumns));
+#endif
 
 #define GUARD(VAL) std::isinf(VAL) ? -9999 : VAL
 #define OUT(STREAM,TAG) STREAM << std::fixed << TAG << ","
@@ -37,54 +67,55 @@ void write_file_info(const caf::SRSpillProxy* sr, const caf::SRInteractionTruthD
     output  << CSV(sr->hdr.run) << CSV(sr->hdr.evt) << CSV(sr->hdr.subrun)
             << CSV(i.nu_id) << CSV(vars::image_id(i)) << CSV(vars::id(i))
             << CSV(std::string(sr->hdr.sourceName))
-            << std::endl;
+            << "\n";
 }
 
 /**
  * Writes reconstructed variables (truth and reco) for selected/signal
  * interactions.
+ * @param rows the RowTree (see rows::kPairColumns) to write to.
  * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
  * current spill.
  * @param i the truth interaction (signal)
  * @param j the reco interaction (selected).
  * @return None.
 */
-void write_pair(const caf::SRSpillProxy* sr, const caf::SRInteractionTruthDLPProxy& i, const caf::SRInteractionDLPProxy& j)
+void write_pair(RowTree & rows, const caf::SRSpillProxy* sr, const caf::SRInteractionTruthDLPProxy& i, const caf::SRInteractionDLPProxy& j)
 {
-    output  << CSV(sr->hdr.run) << CSV(sr->hdr.evt) << CSV(sr->hdr.subrun)
-            //<< CSV(i.nu_energy_init + i.nu_position[2]) << CSV(sr->hdr.evt) << CSV(sr->hdr.subrun)
-            << CSV(i.nu_id) << CSV(vars::image_id(i)) << CSV(vars::id(i))
-            << CSV(sr->hdr.triggerinfo.global_trigger_det_time)
-            << CSV(vars::category(i))
-            << CSV(vars::category_topology(i))
-            << CSV(vars::category_interaction_mode(i))
-            << CSV(vars::leading_muon_ke(i))
-            << CSV(vars::leading_muon_ke(j))
-            << CSV(vars::leading_proton_ke(i))
-            << CSV(vars::leading_proton_ke(j))
-            << CSV(vars::visible_energy(i))
-            << CSV(vars::visible_energy(j))
-            << CSV(vars::leading_muon_pt(i))
-            << CSV(vars::leading_muon_pt(j))
-            << CSV(vars::leading_proton_pt(i))
-            << CSV(vars::leading_proton_pt(j))
-            << CSV(vars::muon_polar_angle(i))
-            << CSV(vars::muon_polar_angle(j))
-            << CSV(vars::muon_azimuthal_angle(i))
-            << CSV(vars::muon_azimuthal_angle(j))
-            << CSV(vars::opening_angle(i))
-            << CSV(vars::opening_angle(j))
-            << CSV(vars::interaction_pt(i))
-            << CSV(vars::interaction_pt(j))
-            << CSV(vars::phiT(i)) << CSV(vars::phiT(j))
-            << CSV(vars::alphaT(i)) << CSV(vars::alphaT(j))
-            << CSV(vars::muon_softmax(j)) << CSV(vars::proton_softmax(j))
-            << CSV(cuts::all_1mu1p_cut(j))
-            << CSV(cuts::all_1muNp_cut(j))
-            << CSV(cuts::all_1muX_cut(j))
-            << CSV(cuts::crtpmt_veto(sr))
-            << CSV(j.volume_id)
-            << std::endl;
+    vars::KinematicSummary si(vars::summarize(i)), sj(vars::summarize(j));
+    rows    << sr->hdr.run << sr->hdr.evt << sr->hdr.subrun
+            << i.nu_id << vars::image_id(i) << vars::id(i)
+            << sr->hdr.triggerinfo.global_trigger_det_time
+            << vars::category(i, si.topology)
+            << vars::category_topology(i, si.topology)
+            << vars::category_interaction_mode(i)
+            << vars::leading_muon_ke(i, si)
+            << vars::leading_muon_ke(j, sj)
+            << vars::leading_proton_ke(i, si)
+            << vars::leading_proton_ke(j, sj)
+            << vars::visible_energy(i, si)
+            << vars::visible_energy(j, sj)
+            << vars::leading_muon_pt(i, si)
+            << vars::leading_muon_pt(j, sj)
+            << vars::leading_proton_pt(i, si)
+            << vars::leading_proton_pt(j, sj)
+            << vars::muon_polar_angle(i, si)
+            << vars::muon_polar_angle(j, sj)
+            << vars::muon_azimuthal_angle(i, si)
+            << vars::muon_azimuthal_angle(j, sj)
+            << vars::opening_angle(i, si)
+            << vars::opening_angle(j, sj)
+            << vars::interaction_pt(i, si)
+            << vars::interaction_pt(j, sj)
+            << vars::phiT(i, si) << vars::phiT(j, sj)
+            << vars::alphaT(i, si) << vars::alphaT(j, sj)
+            << vars::muon_softmax(j, sj) << vars::proton_softmax(j, sj)
+            << cuts::all_1mu1p_cut(j)
+            << cuts::all_1muNp_cut(j)
+            << cuts::all_1muX_cut(j)
+            << cuts::crtpmt_veto(sr)
+            << j.volume_id;
+    rows.fill();
 }
 
 const SpillMultiVar kInfoVar([](const caf::SRSpillProxy* sr)
@@ -102,9 +133,8 @@ const SpillMultiVar kInfoVar([](const caf::SRSpillProxy* sr)
             {
                 if(cuts::matched(i))
                 {
-                    OUT(output, "SIGNAL");
                     const auto & r = sr->dlp[i.match[0]];
-                    write_pair(sr, i, r);
+                    write_pair(signal_rows, sr, i, r);
 
                     if(cuts::fiducial_cut(r) && !cuts::containment_cut(r))
                     {
@@ -127,12 +157,23 @@ const SpillMultiVar kInfoVar([](const caf::SRSpillProxy* sr)
             if(cuts::matched(i))
             {
                 const auto & t = sr->dlp_true[i.match[0]];
-                OUT(output, "SELECTED");
-                write_pair(sr, t, i);
+                write_pair(selected_rows, sr, t, i);
+
+                if(cuts::crtpmt_veto(sr) && std::abs(sr->hdr.triggerinfo.global_trigger_det_time - 1500) < kTriggerWindow)
+                {
+                    if(cuts::all_1mu1p_cut(i)) selected_1mu1p_rows.fill(selected_rows);
+                    if(cuts::all_1muNp_cut(i)) selected_1muNp_rows.fill(selected_rows);
+                    if(cuts::all_1muX_cut(i)) selected_1muX_rows.fill(selected_rows);
+                }
             }
         }
     }
 
+#ifdef EVENTS_TREE
+    event_rows << sr->hdr.run << sr->hdr.subrun << sr->hdr.evt;
+    event_rows.fill();
+#endif
+
     return std::vector<double>{1};
 });
 
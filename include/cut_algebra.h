@@ -0,0 +1,265 @@
+/**
+ * @file cut_algebra.h
+ * @brief Header file defining compile-time expressions over the cuts in
+ * cuts.h, with conjunctions ordered by their estimated cost.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef CUT_ALGEBRA_H
+#define CUT_ALGEBRA_H
+
+#include <array>
+#include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+namespace cuts
+{
+    /**
+     * Compile-time estimate of the cost of a cut: the relative cost of one
+     * evaluation (roughly the number of attributes read) and the expected
+     * fraction of interactions passing it.
+    */
+    struct CutCost
+    {
+        double cost;
+        double pass;
+    };
+
+    /**
+     * Description of an interaction-level cut in terms of the cut mask (see
+     * cut_mask() in cuts.h). The cut passes if all "require" bits are set and
+     * no "veto" bits are set. Cuts that cannot be expressed this way are
+     * flagged as not cached.
+    */
+    struct MaskCut
+    {
+        uint32_t require;
+        uint32_t veto;
+        bool cached;
+    };
+
+    /**
+     * Apply a MaskCut to a cut mask.
+     * @param mask the cut mask of the interaction (see cut_mask()).
+     * @param cut the MaskCut to apply.
+     * @return true if the mask passes the cut.
+    */
+    constexpr bool passes(uint32_t mask, const MaskCut & cut) { return (mask & cut.require) == cut.require && (mask & cut.veto) == 0; }
+
+    /**
+     * Check if two MaskCuts are identical.
+     * @param a the first MaskCut.
+     * @param b the second MaskCut.
+     * @return true if both MaskCuts have the same representation.
+    */
+    constexpr bool same_mask(const MaskCut & a, const MaskCut & b) { return a.require == b.require && a.veto == b.veto && a.cached == b.cached; }
+
+    /**
+     * Cost estimate of one of the cuts in cuts.h (defined there).
+     * @tparam T the type of interaction (true or reco).
+     * @param f the cut function.
+     * @return the CutCost of the cut function.
+    */
+    template<class T>
+        constexpr CutCost cut_cost(bool (*f)(const T &));
+
+    /**
+     * MaskCut representation of one of the cuts in cuts.h (defined there).
+     * @tparam T the type of interaction (true or reco).
+     * @param f the cut function.
+     * @return the MaskCut equivalent to the cut function.
+    */
+    template<class T>
+        constexpr MaskCut mask_cut(bool (*f)(const T &));
+
+    /**
+     * Base class of the cut expressions. Expressions are empty types: the
+     * structure of an expression (and the order in which its terms are
+     * evaluated) is fixed at compile time.
+    */
+    struct CutExpr {};
+
+    /**
+     * Check if a type is a cut expression.
+     * @tparam E the type to check.
+    */
+    template<class E>
+    constexpr bool is_cut_expr_v = std::is_base_of_v<CutExpr, E>;
+
+    /**
+     * Figure of merit used to order the terms of a conjunction: the cost of
+     * a term per rejected interaction. Terms that are cheap and reject
+     * often have a low rank and are evaluated first.
+     * @param c the cost estimate of the term.
+     * @return the rank of the term.
+    */
+    constexpr double cut_rank(const CutCost & c) { return c.pass < 1 ? c.cost / (1 - c.pass) : 1e30; }
+
+    /**
+     * Computes the evaluation order of the terms of a conjunction: a stable
+     * insertion sort of the terms by cut_rank().
+     * @tparam Es the terms of the conjunction.
+     * @return the indices of the terms, in evaluation order.
+    */
+    template<class... Es>
+        constexpr std::array<size_t, sizeof...(Es)> cut_order()
+        {
+            constexpr size_t n(sizeof...(Es));
+            std::array<double, n> rank{cut_rank(Es::cost())...};
+            std::array<size_t, n> order{};
+            for(size_t i(0); i < n; ++i)
+                order[i] = i;
+            for(size_t i(1); i < n; ++i)
+            {
+                for(size_t j(i); j > 0 && rank[order[j]] < rank[order[j - 1]]; --j)
+                {
+                    size_t t(order[j]);
+                    order[j] = order[j - 1];
+                    order[j - 1] = t;
+                }
+            }
+            return order;
+        }
+
+    /**
+     * Primitive cut expression wrapping one of the cuts in cuts.h.
+     * @tparam F the cut function.
+    */
+    template<auto F>
+    struct Cut : CutExpr
+    {
+        static constexpr CutCost cost() { return cut_cost(F); }
+        static constexpr MaskCut mask() { return mask_cut(F); }
+
+        template<class T>
+            static bool evaluate(const T & interaction) { return F(interaction); }
+
+        template<class T>
+            bool operator()(const T & interaction) const { return evaluate(interaction); }
+    };
+
+    /**
+     * Logical negation of a cut expression.
+     * @tparam E the negated expression.
+    */
+    template<class E>
+    struct Not : CutExpr
+    {
+        static constexpr CutCost cost() { return {E::cost().cost, 1 - E::cost().pass}; }
+
+        /**
+         * The negation has a mask representation only if the negated
+         * expression depends on a single bit of the cut mask.
+        */
+        static constexpr MaskCut mask()
+        {
+            constexpr MaskCut m(E::mask());
+            if(m.cached && m.veto == 0 && m.require != 0 && (m.require & (m.require - 1)) == 0)
+                return {0, m.require, true};
+            if(m.cached && m.require == 0 && m.veto != 0 && (m.veto & (m.veto - 1)) == 0)
+                return {m.veto, 0, true};
+            return {0, 0, false};
+        }
+
+        template<class T>
+            static bool evaluate(const T & interaction) { return !E::evaluate(interaction); }
+
+        template<class T>
+            bool operator()(const T & interaction) const { return evaluate(interaction); }
+    };
+
+    /**
+     * Conjunction of cut expressions. The terms are evaluated in increasing
+     * order of cut_rank() (ties keep the written order) and the evaluation
+     * stops at the first failing term. The cuts are pure functions of the
+     * interaction, so the order does not change the result.
+     * @tparam Es the terms of the conjunction.
+    */
+    template<class... Es>
+    struct And : CutExpr
+    {
+        static constexpr size_t kTerms = sizeof...(Es);
+
+        static constexpr std::array<size_t, kTerms> order = cut_order<Es...>();
+
+        static constexpr CutCost cost()
+        {
+            double total(0), pass(1);
+            CutCost c[] = {Es::cost()...};
+            for(size_t i(0); i < kTerms; ++i)
+            {
+                total += pass * c[order[i]].cost;
+                pass *= c[order[i]].pass;
+            }
+            return {total, pass};
+        }
+
+        static constexpr MaskCut mask()
+        {
+            MaskCut result{0, 0, true};
+            MaskCut m[] = {Es::mask()...};
+            for(size_t i(0); i < kTerms; ++i)
+            {
+                result.require |= m[i].require;
+                result.veto |= m[i].veto;
+                result.cached = result.cached && m[i].cached;
+            }
+            if(!result.cached) return {0, 0, false};
+            return result;
+        }
+
+        template<class T, size_t... I>
+            static bool evaluate(const T & interaction, std::index_sequence<I...>)
+            {
+                return (std::tuple_element_t<order[I], std::tuple<Es...>>::evaluate(interaction) && ...);
+            }
+
+        template<class T>
+            static bool evaluate(const T & interaction) { return evaluate(interaction, std::make_index_sequence<kTerms>{}); }
+
+        template<class T>
+            bool operator()(const T & interaction) const { return evaluate(interaction); }
+    };
+
+    /**
+     * Helpers for flattening nested conjunctions.
+    */
+    template<class E>
+    struct conjunction_terms { using type = std::tuple<E>; };
+
+    template<class... Es>
+    struct conjunction_terms<And<Es...>> { using type = std::tuple<Es...>; };
+
+    template<class L, class R>
+    struct conjoin;
+
+    template<class... Ls, class... Rs>
+    struct conjoin<std::tuple<Ls...>, std::tuple<Rs...>> { using type = And<Ls..., Rs...>; };
+
+    /**
+     * Builds the conjunction of two cut expressions. Nested conjunctions are
+     * flattened so that all terms take part in the ordering.
+     * @tparam L the left expression.
+     * @tparam R the right expression.
+     * @return the conjunction of the two expressions.
+    */
+    template<class L, class R, std::enable_if_t<is_cut_expr_v<L> && is_cut_expr_v<R>, int> = 0>
+        constexpr auto operator&&(L, R)
+        {
+            return typename conjoin<typename conjunction_terms<L>::type, typename conjunction_terms<R>::type>::type{};
+        }
+
+    /**
+     * Builds the negation of a cut expression.
+     * @tparam E the expression.
+     * @return the negation of the expression.
+    */
+    template<class E, std::enable_if_t<is_cut_expr_v<E>, int> = 0>
+        constexpr auto operator!(E)
+        {
+            return Not<E>{};
+        }
+}
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file cut_cache.h
+ * @brief Header file defining a per-spill cache of interaction cut results.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef CUT_CACHE_H
+#define CUT_CACHE_H
+
+#include <vector>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "cuts.h"
+#include "snapshot.h"
+
+/**
+ * Per-spill cache of the cut mask (see cuts::cut_mask()) for each reco and
+ * true interaction, keyed by the index of the interaction within sr->dlp or
+ * sr->dlp_true. The mask of an interaction is computed on first use and
+ * reused by every variable evaluated on the same spill. The masks are
+ * evaluated on the views of a SpillSnapshot rather than on the proxies, so
+ * the selection attributes of the spill are read out of the proxies only
+ * once.
+*/
+struct CutCache
+{
+    /**
+     * Marker for a filled cache entry. Kept out of the range of CutBits.
+    */
+    static constexpr uint32_t kFilled = 1u << 31;
+
+    std::vector<uint32_t> reco;
+    std::vector<uint32_t> truth;
+    SpillSnapshot snapshot;
+
+    /**
+     * Invalidates all entries of the cache and sizes it for a new spill.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return none.
+    */
+    void reset(const caf::SRSpillProxy* sr)
+    {
+        reco.assign(sr->dlp.size(), 0);
+        truth.assign(sr->dlp_true.size(), 0);
+        snapshot.reset();
+    }
+
+    /**
+     * Retrieves the cut mask of a reco interaction.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the reco interaction.
+     * @return the cut mask of the interaction.
+    */
+    uint32_t reco_mask(const caf::SRSpillProxy* sr, size_t k)
+    {
+        if(!(reco[k] & kFilled))
+            reco[k] = cuts::cut_mask(snapshot.reco(sr, k)) | kFilled;
+        return reco[k];
+    }
+
+    /**
+     * Retrieves the cut mask of a true interaction.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the true interaction.
+     * @return the cut mask of the interaction.
+    */
+    uint32_t true_mask(const caf::SRSpillProxy* sr, size_t k)
+    {
+        if(!(truth[k] & kFilled))
+            truth[k] = cuts::cut_mask(snapshot.truth(sr, k)) | kFilled;
+        return truth[k];
+    }
+
+    /**
+     * Checks whether a cut on reco interactions is read from the cut mask.
+     * @tparam F the cut function.
+     * @return true if the cut has a mask representation.
+    */
+    template<bool (*F)(const caf::SRInteractionDLPProxy &)>
+        static constexpr bool cached_reco() { return cuts::mask_cut(F).cached; }
+
+    /**
+     * Checks whether a cut on true interactions is read from the cut mask.
+     * @tparam F the cut function.
+     * @return true if the cut has a mask representation.
+    */
+    template<bool (*F)(const caf::SRInteractionTruthDLPProxy &)>
+        static constexpr bool cached_true() { return cuts::mask_cut(F).cached; }
+
+    /**
+     * Applies a cut to a reco interaction using the cached cut mask. Cuts
+     * without a mask representation are evaluated directly.
+     * @tparam F the cut function.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the reco interaction.
+     * @return true if the interaction passes the cut.
+    */
+    template<bool (*F)(const caf::SRInteractionDLPProxy &)>
+        bool select_reco(const caf::SRSpillProxy* sr, size_t k)
+        {
+            constexpr cuts::MaskCut cut(cuts::mask_cut(F));
+            if constexpr (cut.cached)
+                return cuts::passes(reco_mask(sr, k), cut);
+            else
+                return F(sr->dlp[k]);
+        }
+
+    /**
+     * Applies a cut to a true interaction using the cached cut mask. Cuts
+     * without a mask representation are evaluated directly.
+     * @tparam F the cut function.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the true interaction.
+     * @return true if the interaction passes the cut.
+    */
+    template<bool (*F)(const caf::SRInteractionTruthDLPProxy &)>
+        bool select_true(const caf::SRSpillProxy* sr, size_t k)
+        {
+            constexpr cuts::MaskCut cut(cuts::mask_cut(F));
+            if constexpr (cut.cached)
+                return cuts::passes(true_mask(sr, k), cut);
+            else
+                return F(sr->dlp_true[k]);
+        }
+};
+#endif
@@ -0,0 +1,108 @@
+/**
+ * @file cut_flow.h
+ * @brief Header file defining ordered cut flows over the cuts in cuts.h.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef CUT_FLOW_H
+#define CUT_FLOW_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "record_traits.h"
+#include "cuts.h"
+#include "cut_cache.h"
+
+/**
+ * An ordered list of (incremental) cuts. An interaction reaches stage n of
+ * the flow if it passes each of the first n stages. Stages are evaluated in
+ * order and the evaluation stops at the first failing stage, so each stage
+ * costs at most one cut evaluation. The stage reached by an interaction
+ * encodes the result of every cumulative cut in the flow: the interaction
+ * passes the cumulative cut of stage n if and only if the stage reached is
+ * at least n.
+ * @tparam T the type of interaction (true or reco).
+ * @tparam Stages the cuts defining each stage, in order.
+*/
+template<class T, bool (*... Stages)(const T &)>
+struct CutFlow
+{
+    /**
+     * The number of stages in the flow.
+    */
+    static constexpr size_t kStages = sizeof...(Stages);
+
+    /**
+     * Evaluates the flow on an interaction.
+     * @param interaction to apply the flow on.
+     * @return the highest stage reached by the interaction (0 if the first
+     * stage fails).
+    */
+    static size_t evaluate(const T & interaction)
+    {
+        size_t n(0);
+        ((Stages(interaction) && ++n) && ...);
+        return n;
+    }
+
+    /**
+     * Evaluates the flow on an interaction using the per-spill cut cache.
+     * @param cache the per-spill cut cache.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the interaction within sr->dlp (reco) or
+     * sr->dlp_true (true).
+     * @return the highest stage reached by the interaction (0 if the first
+     * stage fails).
+    */
+    static size_t evaluate(CutCache & cache, const caf::SRSpillProxy* sr, size_t k)
+    {
+        size_t n(0);
+        if constexpr (!is_truth_v<T>)
+            ((cache.select_reco<Stages>(sr, k) && ++n) && ...);
+        else
+            ((cache.select_true<Stages>(sr, k) && ++n) && ...);
+        return n;
+    }
+};
+
+namespace cuts
+{
+    /**
+     * Cut flow of the 1mu1p selection: fiducial volume (1), containment (2),
+     * topological (3), and flash time (4).
+    */
+    using flow_1mu1p = CutFlow<caf::SRInteractionDLPProxy, fiducial_cut, containment_cut, topological_1mu1p_cut, flash_cut>;
+
+    /**
+     * Cut flow of the 1muNp selection: fiducial volume (1), containment (2),
+     * topological (3), and flash time (4).
+    */
+    using flow_1muNp = CutFlow<caf::SRInteractionDLPProxy, fiducial_cut, containment_cut, topological_1muNp_cut, flash_cut>;
+
+    /**
+     * Cut flow of the 1muX selection: fiducial volume (1), containment (2),
+     * topological (3), and flash time (4).
+    */
+    using flow_1muX = CutFlow<caf::SRInteractionDLPProxy, fiducial_cut, containment_cut, topological_1muX_cut, flash_cut>;
+
+    /**
+     * Cut flow of the 1mu1p selection on data: fiducial volume (1),
+     * containment (2), topological (3), and flash time (4).
+    */
+    using flow_1mu1p_data = CutFlow<caf::SRInteractionDLPProxy, fiducial_cut, containment_cut, topological_1mu1p_cut, flash_cut_data>;
+
+    /**
+     * Cut flow of the 1muNp selection on data: fiducial volume (1),
+     * containment (2), topological (3), and flash time (4).
+    */
+    using flow_1muNp_data = CutFlow<caf::SRInteractionDLPProxy, fiducial_cut, containment_cut, topological_1muNp_cut, flash_cut_data>;
+
+    /**
+     * Cut flow of the 1muX selection on data: fiducial volume (1),
+     * containment (2), topological (3), and flash time (4).
+    */
+    using flow_1muX_data = CutFlow<caf::SRInteractionDLPProxy, fiducial_cut, containment_cut, topological_1muX_cut, flash_cut_data>;
+}
+#endif
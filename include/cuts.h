@@ -9,8 +9,13 @@
 #include <functional>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <numeric>
+#include <algorithm>
+#include <cstdint>
+
+#include "record_traits.h"
+#include "cut_algebra.h"
+#include "instrumentation.h"
 
 namespace cuts
 {
@@ -59,7 +64,7 @@ namespace cuts
             if(p.is_primary)
             {
                 double energy(p.pid > 1 ? p.csda_ke : p.calo_ke);
-                if constexpr (std::is_same_v<T, caf::SRParticleTruthDLPProxy>)
+                if constexpr (is_truth_v<T>)
                     energy = p.energy_deposit;
 
                 if((p.pid == 2 && energy > 143.425) || (p.pid != 2 && p.pid < 4 && energy > 25) || (p.pid == 4 && energy > 50))
@@ -68,23 +73,121 @@ namespace cuts
             return passes;
         }
 
+    /**
+     * Packed topology code. The number of final state signal primaries of
+     * each particle type (photon, electron, muon, pion, proton) is stored in
+     * a saturating 6-bit counter, with the counter for PID i occupying bits
+     * [6i, 6i+6) of the word.
+    */
+    typedef uint32_t topology_t;
+
+    /**
+     * Number of bits used by each counter of the topology code.
+    */
+    constexpr uint32_t kTopologyBits = 6;
+
+    /**
+     * Maximum value of a counter in the topology code. Counters saturate at
+     * this value.
+    */
+    constexpr uint32_t kTopologyMax = (1u << kTopologyBits) - 1;
+
+    /**
+     * Build a topology code from the counts of each particle type.
+     * @param ph the number of photons.
+     * @param e the number of electrons.
+     * @param mu the number of muons.
+     * @param pi the number of pions.
+     * @param p the number of protons.
+     * @return the packed topology code.
+    */
+    constexpr topology_t make_topology(uint32_t ph, uint32_t e, uint32_t mu, uint32_t pi, uint32_t p)
+    {
+        return (std::min(ph, kTopologyMax) << (0 * kTopologyBits))
+             | (std::min(e, kTopologyMax) << (1 * kTopologyBits))
+             | (std::min(mu, kTopologyMax) << (2 * kTopologyBits))
+             | (std::min(pi, kTopologyMax) << (3 * kTopologyBits))
+             | (std::min(p, kTopologyMax) << (4 * kTopologyBits));
+    }
+
+    /**
+     * Retrieve the count of a particle type from a topology code.
+     * @param code the packed topology code.
+     * @param pid the particle type (0-4).
+     * @return the (saturated) count of the particle type.
+    */
+    constexpr uint32_t topology_count(topology_t code, uint32_t pid) { return (code >> (pid * kTopologyBits)) & kTopologyMax; }
+
+    /**
+     * Increment the count of a particle type within a topology code. The
+     * counter saturates instead of overflowing into its neighbor.
+     * @param code the packed topology code.
+     * @param pid the particle type (0-4).
+     * @return the updated topology code.
+    */
+    constexpr topology_t topology_increment(topology_t code, uint32_t pid)
+    {
+        return topology_count(code, pid) < kTopologyMax ? code + (1u << (pid * kTopologyBits)) : code;
+    }
+
+    /**
+     * Check if a topology code matches 1mu1p (exactly one muon and one proton
+     * and no other final state signal particles).
+     * @param code the packed topology code.
+     * @return true if the topology is 1mu1p.
+    */
+    constexpr bool is_1mu1p(topology_t code) { return code == make_topology(0, 0, 1, 0, 1); }
+
+    /**
+     * Check if a topology code matches 1muNp (exactly one muon, at least one
+     * proton, and no other final state signal particles).
+     * @param code the packed topology code.
+     * @return true if the topology is 1muNp.
+    */
+    constexpr bool is_1muNp(topology_t code)
+    {
+        return (code & ~make_topology(0, 0, 0, 0, kTopologyMax)) == make_topology(0, 0, 1, 0, 0) && topology_count(code, 4) >= 1;
+    }
+
+    /**
+     * Check if a topology code matches 1muX (exactly one muon).
+     * @param code the packed topology code.
+     * @return true if the topology is 1muX.
+    */
+    constexpr bool is_1muX(topology_t code) { return topology_count(code, 2) == 1; }
+
+    /**
+     * Decode a topology code into its string representation.
+     * @param code the packed topology code.
+     * @return the topology as a string (e.g 0ph0e1mu0pi1p).
+    */
+    inline std::string topology_string(topology_t code)
+    {
+        return std::to_string(topology_count(code, 0)) + "ph"
+             + std::to_string(topology_count(code, 1)) + "e"
+             + std::to_string(topology_count(code, 2)) + "mu"
+             + std::to_string(topology_count(code, 3)) + "pi"
+             + std::to_string(topology_count(code, 4)) + "p";
+    }
+
     /**
      * Count the primaries of the interaction with cuts applied to each particle.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to find the topology of.
      * @return the count of primaries of each particle type within the
-     * interaction.
+     * interaction as a packed topology code.
      */
     template<class T>
-        std::vector<uint32_t> count_primaries(const T & interaction)
+        topology_t count_primaries(const T & interaction)
         {
-            std::vector<uint32_t> counts(5, 0);
-            for(auto &p : interaction.particles)
+            topology_t code(0);
+            for(const auto &p : interaction.particles)
             {
-                if(final_state_signal(p))
-                    ++counts[p.pid];
+                int pid(p.pid);
+                if(pid >= 0 && pid < 5 && final_state_signal(p))
+                    code = topology_increment(code, pid);
             }
-            return counts;
+            return code;
         }
 
     /**
@@ -94,17 +197,7 @@ namespace cuts
      * @return the topology of the interaction as a string (e.g 0ph0e1mu0pi1p).
      */
     template<class T>
-        std::string topology(const T & interaction)
-        {
-            std::vector<uint32_t> counts(count_primaries(interaction));
-            std::stringstream ss;
-            ss  << counts[0] << "ph"
-                << counts[1] << "e"
-                << counts[2] << "mu"
-                << counts[3] << "pi"
-                << counts[4] << "p";
-            return ss.str();
-        }
+        std::string topology(const T & interaction) { return topology_string(count_primaries(interaction)); }
 
     /**
      * Apply no cut (all interactions/particles passed).
@@ -147,7 +240,7 @@ namespace cuts
      * @return true if the interaction has a 1mu1p topology.
      */
     template<class T>
-        bool topological_1mu1p_cut(const T & interaction) { return topology<T>(interaction) == "0ph0e1mu0pi1p"; }
+        bool topological_1mu1p_cut(const T & interaction) { return is_1mu1p(count_primaries(interaction)); }
     
     /**
      * Apply a 1muNp topological cut. The interaction must have a topology
@@ -158,11 +251,7 @@ namespace cuts
      * @return true if the interaction has a 1muNp topology.
      */
     template<class T>
-        bool topological_1muNp_cut(const T & interaction)
-        {
-            std::vector<uint32_t> c(count_primaries(interaction));
-            return c[0] == 0 && c[1] == 0 && c[2] == 1 && c[3] == 0 && c[4] >= 1;
-        }
+        bool topological_1muNp_cut(const T & interaction) { return is_1muNp(count_primaries(interaction)); }
 
     /**
      * Apply a 1muX topological cut. The interaction must have a topology
@@ -173,11 +262,7 @@ namespace cuts
      * @return true if the interaction has a 1muX topology.
      */
     template<class T>
-        bool topological_1muX_cut(const T & interaction)
-        {
-            std::vector<uint32_t> c(count_primaries(interaction));
-            return c[2] == 1;
-        }
+        bool topological_1muX_cut(const T & interaction) { return is_1muX(count_primaries(interaction)); }
     
     /**
      * Apply a flash time cut. The interaction must be matched to an in-time
@@ -245,6 +330,19 @@ namespace cuts
         return crtpmt_matched;
     }
 
+    /**
+     * The composite cuts below are defined by cut expressions (see
+     * cut_algebra.h). The terms of each conjunction are evaluated in order of
+     * their estimated cost (see cut_cost()) rather than in the written order.
+     * The static_asserts at the end of this file check that each expression
+     * has the same mask representation as the composite it implements, and
+     * selection_benchmark --check compares each composite with its original
+     * chain of primitive cuts on synthetic spills.
+    */
+
+    template<class T>
+        using fiducial_containment_expr = decltype(Cut<fiducial_cut<T>>() && Cut<containment_cut<T>>());
+
     /**
      * Apply a fiducial and containment cut (logical "and" of both).
      * @tparam T the type of interaction (true or reco).
@@ -252,7 +350,10 @@ namespace cuts
      * @return true if the interaction passes the fiducial and containment cut.
      */
     template<class T>
-        bool fiducial_containment_cut(const T & interaction) { return fiducial_cut<T>(interaction) && containment_cut<T>(interaction); }
+        bool fiducial_containment_cut(const T & interaction) { return fiducial_containment_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using fiducial_containment_topological_1mu1p_expr = decltype(Cut<fiducial_cut<T>>() && Cut<containment_cut<T>>() && Cut<topological_1mu1p_cut<T>>());
 
     /**
      * Apply a fiducial, containment, and topological (1mu1p) cut (logical
@@ -263,7 +364,10 @@ namespace cuts
      * topological cut.
      */
     template<class T>
-        bool fiducial_containment_topological_1mu1p_cut(const T & interaction) { return fiducial_cut<T>(interaction) && containment_cut<T>(interaction) && topological_1mu1p_cut<T>(interaction); }
+        bool fiducial_containment_topological_1mu1p_cut(const T & interaction) { return fiducial_containment_topological_1mu1p_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using fiducial_containment_topological_1muNp_expr = decltype(Cut<fiducial_cut<T>>() && Cut<containment_cut<T>>() && Cut<topological_1muNp_cut<T>>());
 
     /**
      * Apply a fiducial, containment, and topological (1muNp) cut (logical
@@ -274,7 +378,10 @@ namespace cuts
      * topological cut.
      */
     template<class T>
-        bool fiducial_containment_topological_1muNp_cut(const T & interaction) { return fiducial_cut<T>(interaction) && containment_cut<T>(interaction) && topological_1muNp_cut<T>(interaction); }
+        bool fiducial_containment_topological_1muNp_cut(const T & interaction) { return fiducial_containment_topological_1muNp_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using fiducial_containment_topological_1muX_expr = decltype(Cut<fiducial_cut<T>>() && Cut<containment_cut<T>>() && Cut<topological_1muX_cut<T>>());
 
     /**
      * Apply a fiducial, containment, and topological (1muX) cut (logical
@@ -285,7 +392,10 @@ namespace cuts
      * topological cut.
      */
     template<class T>
-        bool fiducial_containment_topological_1muX_cut(const T & interaction) { return fiducial_cut<T>(interaction) && containment_cut<T>(interaction) && topological_1muX_cut<T>(interaction); }
+        bool fiducial_containment_topological_1muX_cut(const T & interaction) { return fiducial_containment_topological_1muX_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using all_1mu1p_expr = decltype(Cut<topological_1mu1p_cut<T>>() && Cut<fiducial_cut<T>>() && Cut<flash_cut<T>>() && Cut<containment_cut<T>>());
 
     /**
      * Apply a fiducial, containment, topological (1mu1p), and flash time cut
@@ -296,7 +406,10 @@ namespace cuts
      * topological, and flash time cut.
      */
     template<class T>
-        bool all_1mu1p_cut(const T & interaction) { return topological_1mu1p_cut<T>(interaction) && fiducial_cut<T>(interaction) && flash_cut<T>(interaction) && containment_cut<T>(interaction); }
+        bool all_1mu1p_cut(const T & interaction) { return all_1mu1p_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using all_1muNp_expr = decltype(Cut<topological_1muNp_cut<T>>() && Cut<fiducial_cut<T>>() && Cut<flash_cut<T>>() && Cut<containment_cut<T>>());
 
     /**
      * Apply a fiducial, containment, topological (1muNp), and flash time cut
@@ -307,8 +420,11 @@ namespace cuts
      * topological, and flash time cut.
      */
     template<class T>
-        bool all_1muNp_cut(const T & interaction) { return topological_1muNp_cut<T>(interaction) && fiducial_cut<T>(interaction) && flash_cut<T>(interaction) && containment_cut<T>(interaction); }
+        bool all_1muNp_cut(const T & interaction) { return all_1muNp_expr<T>::evaluate(interaction); }
     
+    template<class T>
+        using all_1muX_expr = decltype(Cut<topological_1muX_cut<T>>() && Cut<fiducial_cut<T>>() && Cut<flash_cut<T>>() && Cut<containment_cut<T>>());
+
     /**
      * Apply a fiducial, containment, topological (1muX), and flash time cut
      * (logical "and" of each).
@@ -318,7 +434,10 @@ namespace cuts
      * topological, and flash time cut.
      */
     template<class T>
-        bool all_1muX_cut(const T & interaction) { return topological_1muX_cut<T>(interaction) && fiducial_cut<T>(interaction) && flash_cut<T>(interaction) && containment_cut<T>(interaction); }
+        bool all_1muX_cut(const T & interaction) { return all_1muX_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using all_1mu1p_data_expr = decltype(Cut<topological_1mu1p_cut<T>>() && Cut<fiducial_cut<T>>() && Cut<flash_cut_data<T>>() && Cut<containment_cut<T>>());
 
     /**
      * Apply a fiducial, containment, topological (1mu1p), and flash time cut
@@ -329,7 +448,10 @@ namespace cuts
      * topological, and flash time cut.
      */
     template<class T>
-        bool all_1mu1p_data_cut(const T & interaction) { return topological_1mu1p_cut<T>(interaction) && fiducial_cut<T>(interaction) && flash_cut_data<T>(interaction) && containment_cut<T>(interaction); }
+        bool all_1mu1p_data_cut(const T & interaction) { return all_1mu1p_data_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using all_1muNp_data_expr = decltype(Cut<topological_1muNp_cut<T>>() && Cut<fiducial_cut<T>>() && Cut<flash_cut_data<T>>() && Cut<containment_cut<T>>());
 
     /**
      * Apply a fiducial, containment, topological (1muNp), and flash time cut
@@ -340,8 +462,11 @@ namespace cuts
      * topological, and flash time cut.
      */
     template<class T>
-        bool all_1muNp_data_cut(const T & interaction) { return topological_1muNp_cut<T>(interaction) && fiducial_cut<T>(interaction) && flash_cut_data<T>(interaction) && containment_cut<T>(interaction); }
+        bool all_1muNp_data_cut(const T & interaction) { return all_1muNp_data_expr<T>::evaluate(interaction); }
     
+    template<class T>
+        using all_1muX_data_expr = decltype(Cut<topological_1muX_cut<T>>() && Cut<fiducial_cut<T>>() && Cut<flash_cut_data<T>>() && Cut<containment_cut<T>>());
+
     /**
      * Apply a fiducial, containment, topological (1muX), and flash time cut
      * (logical "and" of each).
@@ -351,7 +476,7 @@ namespace cuts
      * topological, and flash time cut.
      */
     template<class T>
-        bool all_1muX_data_cut(const T & interaction) { return topological_1muX_cut<T>(interaction) && fiducial_cut<T>(interaction) && flash_cut_data<T>(interaction) && containment_cut<T>(interaction); }
+        bool all_1muX_data_cut(const T & interaction) { return all_1muX_data_expr<T>::evaluate(interaction); }
 
     /**
      * Defined the true neutrino interaction classification.
@@ -371,6 +496,9 @@ namespace cuts
     template<class T>
         bool cosmic(const T & interaction) { return !interaction.is_neutrino; }
 
+    template<class T>
+        using matched_neutrino_expr = decltype(Cut<matched<T>>() && Cut<neutrino<T>>());
+
     /**
      * Define the true neutrino interaction classification.
      * @tparam T the type of interaction (true or reco).
@@ -378,7 +506,10 @@ namespace cuts
      * @return true if the interaction is a neutrino interaction.
     */
     template<class T>
-        bool matched_neutrino(const T & interaction) { return interaction.match.size() > 0 && neutrino(interaction); }
+        bool matched_neutrino(const T & interaction) { return matched_neutrino_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using wellreco_neutrino_expr = decltype(Cut<wellreco<T>>() && Cut<neutrino<T>>());
 
     /**
      * Define the true neutrino interaction classification (well-reconstructed).
@@ -387,7 +518,10 @@ namespace cuts
      * @return true if the interaction is a well-reconstructed neutrino interaction.
     */
     template<class T>
-        bool wellreco_neutrino(const T & interaction) { return wellreco(interaction) && neutrino(interaction); }
+        bool wellreco_neutrino(const T & interaction) { return wellreco_neutrino_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using matched_cosmic_expr = decltype(Cut<matched<T>>() && Cut<cosmic<T>>());
 
     /**
      * Define the true neutrino interaction classification.
@@ -396,7 +530,10 @@ namespace cuts
      * @return true if the interaction is a neutrino interaction.
     */
     template<class T>
-        bool matched_cosmic(const T & interaction) { return interaction.match.size() > 0 && cosmic(interaction); }
+        bool matched_cosmic(const T & interaction) { return matched_cosmic_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using signal_1mu1p_expr = decltype(Cut<topological_1mu1p_cut<T>>() && Cut<neutrino<T>>());
 
     /**
      * Define the true 1mu1p interaction classification.
@@ -405,7 +542,10 @@ namespace cuts
      * @return true if the interaction is a 1mu1p neutrino interaction.
      */
     template<class T>
-        bool signal_1mu1p(const T & interaction) { return topological_1mu1p_cut<T>(interaction) && neutrino(interaction); }
+        bool signal_1mu1p(const T & interaction) { return signal_1mu1p_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using signal_1muNp_expr = decltype(Cut<topological_1muNp_cut<T>>() && Cut<neutrino<T>>());
 
     /**
      * Define the true 1muNp interaction classification.
@@ -414,7 +554,7 @@ namespace cuts
      * @return true if the interaction is a 1muNp neutrino interaction.
      */
     template<class T>
-        bool signal_1muNp(const T & interaction) { return topological_1muNp_cut<T>(interaction) && neutrino(interaction); }
+        bool signal_1muNp(const T & interaction) { return signal_1muNp_expr<T>::evaluate(interaction); }
 
     /**
      * Define the true 1muNp interaction classification (N > 1 strictly).
@@ -423,7 +563,14 @@ namespace cuts
      * @return true if the interaction is a 1muNp (N > 1) neutrino interaction.
      */
     template<class T>
-        bool signal_1muNp_Nnot1(const T & interaction) { return !topological_1mu1p_cut(interaction) && topological_1muNp_cut<T>(interaction) && neutrino(interaction); }
+        bool signal_1muNp_Nnot1(const T & interaction)
+        {
+            topology_t code(count_primaries(interaction));
+            return !is_1mu1p(code) && is_1muNp(code) && neutrino(interaction);
+        }
+
+    template<class T>
+        using signal_1muX_expr = decltype(Cut<topological_1muX_cut<T>>() && Cut<neutrino<T>>());
 
     /**
      * Define the true 1muX interaction classification.
@@ -432,7 +579,7 @@ namespace cuts
      * @return true if the interaction is a 1muX neutrino interaction.
      */
     template<class T>
-        bool signal_1muX(const T & interaction) { return topological_1muX_cut<T>(interaction) && neutrino(interaction); }
+        bool signal_1muX(const T & interaction) { return signal_1muX_expr<T>::evaluate(interaction); }
 
     /**
      * Define the true 1muX interaction classification (not 1muNp).
@@ -441,7 +588,14 @@ namespace cuts
      * @return true if the interaction is a 1muX (not 1muNp) neutrino interaction.
      */
     template<class T>
-        bool signal_1muX_notNp(const T & interaction) { return !topological_1muNp_cut(interaction) && topological_1muX_cut<T>(interaction) && neutrino(interaction); }
+        bool signal_1muX_notNp(const T & interaction)
+        {
+            topology_t code(count_primaries(interaction));
+            return !is_1muNp(code) && is_1muX(code) && neutrino(interaction);
+        }
+
+    template<class T>
+        using other_nu_1mu1p_expr = decltype(!Cut<topological_1mu1p_cut<T>>() && Cut<neutrino<T>>());
 
     /**
      * Define the true "other neutrino" interaction classification (1mu1p).
@@ -450,8 +604,11 @@ namespace cuts
      * @return true if the interaction is an "other neutrino" interaction.
      */
     template<class T>
-        bool other_nu_1mu1p(const T & interaction) { return !topological_1mu1p_cut<T>(interaction) && neutrino(interaction); }
+        bool other_nu_1mu1p(const T & interaction) { return other_nu_1mu1p_expr<T>::evaluate(interaction); }
     
+    template<class T>
+        using other_nu_1muNp_expr = decltype(!Cut<topological_1muNp_cut<T>>() && Cut<neutrino<T>>());
+
     /**
      * Define the true "other neutrino" interaction classification (1muNp).
      * @tparam T the type of interaction (true or reco).
@@ -459,7 +616,10 @@ namespace cuts
      * @return true if the interaction is an "other neutrino" interaction.
      */
     template<class T>
-        bool other_nu_1muNp(const T & interaction) { return !topological_1muNp_cut<T>(interaction) && neutrino(interaction); }
+        bool other_nu_1muNp(const T & interaction) { return other_nu_1muNp_expr<T>::evaluate(interaction); }
+
+    template<class T>
+        using other_nu_1muX_expr = decltype(!Cut<topological_1muX_cut<T>>() && Cut<neutrino<T>>());
 
     /**
      * Define the true "other neutrino" interaction classification (1muX).
@@ -468,7 +628,7 @@ namespace cuts
      * @return true if the interaction is an "other neutrino" interaction.
      */
     template<class T>
-        bool other_nu_1muX(const T & interaction) { return !topological_1muX_cut<T>(interaction) && neutrino(interaction); }
+        bool other_nu_1muX(const T & interaction) { return other_nu_1muX_expr<T>::evaluate(interaction); }
 
     /**
      * Define true muon particle classification.
@@ -567,5 +727,166 @@ namespace cuts
     */
     template<class T>
         bool wellreco_muon(const T & particle) { return muon(particle) && wellreco(particle); }
+
+    /**
+     * Bits of the cut mask produced by cut_mask(). Each bit records the
+     * result of one of the primitive interaction-level cuts above.
+    */
+    enum CutBit : uint32_t
+    {
+        kFiducial = 1u << 0,
+        kContainment = 1u << 1,
+        kTopological1mu1p = 1u << 2,
+        kTopological1muNp = 1u << 3,
+        kTopological1muX = 1u << 4,
+        kFlash = 1u << 5,
+        kFlashData = 1u << 6,
+        kWellReco = 1u << 7,
+        kMatched = 1u << 8,
+        kNeutrino = 1u << 9
+    };
+
+    /**
+     * Evaluate every primitive interaction-level cut at once. The primaries
+     * are counted only once for all three topological cuts. With
+     * INSTRUMENTATION, each primitive cut (and the counting of the primaries)
+     * is timed here, as this is where the CutCache pays for the cuts.
+     * @tparam T the type of interaction (true or reco).
+     * @param interaction to evaluate the cuts on.
+     * @return the mask of CutBits passed by the interaction.
+    */
+    template<class T>
+        uint32_t cut_mask(const T & interaction)
+        {
+            topology_t code(INSTRUMENT_VAR(cuts::count_primaries, count_primaries(interaction)));
+            uint32_t mask(0);
+            if(INSTRUMENT_CUT(cuts::fiducial_cut, fiducial_cut<T>(interaction))) mask |= kFiducial;
+            if(INSTRUMENT_CUT(cuts::containment_cut, containment_cut<T>(interaction))) mask |= kContainment;
+            if(is_1mu1p(code)) mask |= kTopological1mu1p;
+            if(is_1muNp(code)) mask |= kTopological1muNp;
+            if(is_1muX(code)) mask |= kTopological1muX;
+            if(INSTRUMENT_CUT(cuts::flash_cut, flash_cut<T>(interaction))) mask |= kFlash;
+            if(INSTRUMENT_CUT(cuts::flash_cut_data, flash_cut_data<T>(interaction))) mask |= kFlashData;
+            if(INSTRUMENT_CUT(cuts::wellreco, wellreco(interaction))) mask |= kWellReco;
+            if(INSTRUMENT_CUT(cuts::matched, matched(interaction))) mask |= kMatched;
+            if(INSTRUMENT_CUT(cuts::neutrino, neutrino<T>(interaction))) mask |= kNeutrino;
+            return mask;
+        }
+
+    /**
+     * Translate one of the interaction-level cuts defined above into its
+     * MaskCut representation. Intended to be evaluated at compile time.
+     * @tparam T the type of interaction (true or reco).
+     * @param f the cut function.
+     * @return the MaskCut equivalent to the cut function.
+    */
+    template<class T>
+        constexpr MaskCut mask_cut(bool (*f)(const T &))
+        {
+            if(f == &no_cut<T>) return {0, 0, true};
+            if(f == &matched<T>) return {kMatched, 0, true};
+            if(f == &wellreco<T>) return {kWellReco, 0, true};
+            if(f == &fiducial_cut<T>) return {kFiducial, 0, true};
+            if(f == &containment_cut<T>) return {kContainment, 0, true};
+            if(f == &topological_1mu1p_cut<T>) return {kTopological1mu1p, 0, true};
+            if(f == &topological_1muNp_cut<T>) return {kTopological1muNp, 0, true};
+            if(f == &topological_1muX_cut<T>) return {kTopological1muX, 0, true};
+            if(f == &flash_cut<T>) return {kFlash, 0, true};
+            if(f == &flash_cut_data<T>) return {kFlashData, 0, true};
+            if(f == &fiducial_containment_cut<T>) return {kFiducial | kContainment, 0, true};
+            if(f == &fiducial_containment_topological_1mu1p_cut<T>) return {kFiducial | kContainment | kTopological1mu1p, 0, true};
+            if(f == &fiducial_containment_topological_1muNp_cut<T>) return {kFiducial | kContainment | kTopological1muNp, 0, true};
+            if(f == &fiducial_containment_topological_1muX_cut<T>) return {kFiducial | kContainment | kTopological1muX, 0, true};
+            if(f == &all_1mu1p_cut<T>) return {kTopological1mu1p | kFiducial | kFlash | kContainment, 0, true};
+            if(f == &all_1muNp_cut<T>) return {kTopological1muNp | kFiducial | kFlash | kContainment, 0, true};
+            if(f == &all_1muX_cut<T>) return {kTopological1muX | kFiducial | kFlash | kContainment, 0, true};
+            if(f == &all_1mu1p_data_cut<T>) return {kTopological1mu1p | kFiducial | kFlashData | kContainment, 0, true};
+            if(f == &all_1muNp_data_cut<T>) return {kTopological1muNp | kFiducial | kFlashData | kContainment, 0, true};
+            if(f == &all_1muX_data_cut<T>) return {kTopological1muX | kFiducial | kFlashData | kContainment, 0, true};
+            if(f == &neutrino<T>) return {kNeutrino, 0, true};
+            if(f == &cosmic<T>) return {0, kNeutrino, true};
+            if(f == &matched_neutrino<T>) return {kMatched | kNeutrino, 0, true};
+            if(f == &wellreco_neutrino<T>) return {kWellReco | kNeutrino, 0, true};
+            if(f == &matched_cosmic<T>) return {kMatched, kNeutrino, true};
+            if(f == &signal_1mu1p<T>) return {kTopological1mu1p | kNeutrino, 0, true};
+            if(f == &signal_1muNp<T>) return {kTopological1muNp | kNeutrino, 0, true};
+            if(f == &signal_1muNp_Nnot1<T>) return {kTopological1muNp | kNeutrino, kTopological1mu1p, true};
+            if(f == &signal_1muX<T>) return {kTopological1muX | kNeutrino, 0, true};
+            if(f == &signal_1muX_notNp<T>) return {kTopological1muX | kNeutrino, kTopological1muNp, true};
+            if(f == &other_nu_1mu1p<T>) return {kNeutrino, kTopological1mu1p, true};
+            if(f == &other_nu_1muNp<T>) return {kNeutrino, kTopological1muNp, true};
+            if(f == &other_nu_1muX<T>) return {kNeutrino, kTopological1muX, true};
+            return {0, 0, false};
+        }
+
+    /**
+     * Compile-time cost estimate of one of the interaction-level cuts defined
+     * above, used to order the terms of cut expressions. The cost is roughly
+     * the number of attributes read per evaluation (the topological cuts loop
+     * over all particles) and the pass fraction is a rough estimate for
+     * BNB simulation with cosmics. Only the relative values matter.
+     * @tparam T the type of interaction (true or reco).
+     * @param f the cut function.
+     * @return the CutCost of the cut function.
+    */
+    template<class T>
+        constexpr CutCost cut_cost(bool (*f)(const T &))
+        {
+            if(f == &no_cut<T>) return {0, 1};
+            if(f == &matched<T>) return {1, 0.8};
+            if(f == &wellreco<T>) return {2, 0.6};
+            if(f == &fiducial_cut<T>) return {4, 0.6};
+            if(f == &containment_cut<T>) return {1, 0.5};
+            if(f == &topological_1mu1p_cut<T>) return {20, 0.1};
+            if(f == &topological_1muNp_cut<T>) return {20, 0.15};
+            if(f == &topological_1muX_cut<T>) return {20, 0.3};
+            if(f == &flash_cut<T>) return {3, 0.3};
+            if(f == &flash_cut_data<T>) return {3, 0.3};
+            if(f == &neutrino<T>) return {1, 0.5};
+            if(f == &cosmic<T>) return {1, 0.5};
+            return {10, 0.5};
+        }
+
+    /**
+     * Static checks that the expression-based composite cuts are equivalent
+     * to their definitions in mask_cut(). Every term of the expressions is a
+     * single bit of the cut mask, so equal masks imply that the composite
+     * selects the same interactions regardless of the evaluation order.
+     * @tparam T the type of interaction (true or reco).
+     * @return true if all composites match.
+    */
+    template<class T>
+        constexpr bool check_composites()
+        {
+            return same_mask(fiducial_containment_expr<T>::mask(), mask_cut(&fiducial_containment_cut<T>))
+                && same_mask(fiducial_containment_topological_1mu1p_expr<T>::mask(), mask_cut(&fiducial_containment_topological_1mu1p_cut<T>))
+                && same_mask(fiducial_containment_topological_1muNp_expr<T>::mask(), mask_cut(&fiducial_containment_topological_1muNp_cut<T>))
+                && same_mask(fiducial_containment_topological_1muX_expr<T>::mask(), mask_cut(&fiducial_containment_topological_1muX_cut<T>))
+                && same_mask(all_1mu1p_expr<T>::mask(), mask_cut(&all_1mu1p_cut<T>))
+                && same_mask(all_1muNp_expr<T>::mask(), mask_cut(&all_1muNp_cut<T>))
+                && same_mask(all_1muX_expr<T>::mask(), mask_cut(&all_1muX_cut<T>))
+                && same_mask(all_1mu1p_data_expr<T>::mask(), mask_cut(&all_1mu1p_data_cut<T>))
+                && same_mask(all_1muNp_data_expr<T>::mask(), mask_cut(&all_1muNp_data_cut<T>))
+                && same_mask(all_1muX_data_expr<T>::mask(), mask_cut(&all_1muX_data_cut<T>))
+                && same_mask(matched_neutrino_expr<T>::mask(), mask_cut(&matched_neutrino<T>))
+                && same_mask(wellreco_neutrino_expr<T>::mask(), mask_cut(&wellreco_neutrino<T>))
+                && same_mask(matched_cosmic_expr<T>::mask(), mask_cut(&matched_cosmic<T>))
+                && same_mask(signal_1mu1p_expr<T>::mask(), mask_cut(&signal_1mu1p<T>))
+                && same_mask(signal_1muNp_expr<T>::mask(), mask_cut(&signal_1muNp<T>))
+                && same_mask(signal_1muX_expr<T>::mask(), mask_cut(&signal_1muX<T>))
+                && same_mask(other_nu_1mu1p_expr<T>::mask(), mask_cut(&other_nu_1mu1p<T>))
+                && same_mask(other_nu_1muNp_expr<T>::mask(), mask_cut(&other_nu_1muNp<T>))
+                && same_mask(other_nu_1muX_expr<T>::mask(), mask_cut(&other_nu_1muX<T>));
+        }
+
+    static_assert(check_composites<caf::SRInteractionDLPProxy>(), "composite cut expressions must match mask_cut()");
+    static_assert(check_composites<caf::SRInteractionTruthDLPProxy>(), "composite cut expressions must match mask_cut()");
+
+    /**
+     * Static checks of the evaluation order: the topological cut (the only
+     * term that loops over the particles) is evaluated last.
+    */
+    static_assert(all_1mu1p_expr<caf::SRInteractionDLPProxy>::order[3] == 0, "topological cut must be evaluated last");
+    static_assert(all_1muNp_data_expr<caf::SRInteractionDLPProxy>::order[3] == 0, "topological cut must be evaluated last");
 }
 #endif
\ No newline at end of file
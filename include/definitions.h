@@ -7,33 +7,62 @@
 #define DEFINITIONS_H
 
 #include <vector>
-#include <map>
 
 #include "sbnana/CAFAna/Core/MultiVar.h"
 #include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "spill_plan.h"
+#include "cut_flow.h"
+#include "instrumentation.h"
+
+/**
+ * Preprocessor wrapper applying a cut to a reco interaction through the
+ * CutCache of a SpillPlan. With INSTRUMENTATION, cuts read from the cached
+ * cut mask are recorded as selections (see INSTRUMENT_SELECT).
+ * @param SEL the cut.
+ * @param PLAN the SpillPlan.
+ * @param SR the SRSpillProxy of the current spill.
+ * @param K the index of the reco interaction.
+ * @return true if the interaction passes the cut.
+*/
+#define SELECT_RECO(SEL,PLAN,SR,K) \
+    INSTRUMENT_SELECT(SEL, CutCache::cached_reco<SEL>(), (PLAN).cache.select_reco<SEL>(SR, K))
+
+/**
+ * Preprocessor wrapper applying a cut to a true interaction through the
+ * CutCache of a SpillPlan (see SELECT_RECO).
+ * @param SEL the cut.
+ * @param PLAN the SpillPlan.
+ * @param SR the SRSpillProxy of the current spill.
+ * @param K the index of the true interaction.
+ * @return true if the interaction passes the cut.
+*/
+#define SELECT_TRUE(SEL,PLAN,SR,K) \
+    INSTRUMENT_SELECT(SEL, CutCache::cached_true<SEL>(), (PLAN).cache.select_true<SEL>(SR, K))
 
 /**
  * Preprocessor wrapper for looping over reco interactions. The SpillMultiVar
  * accepts a vector as a result of some function running over the top-level
  * StandardRecord. This wrapper broadcasts a function across all interactions
- * within the reco interaction.
+ * within the reco interaction. The broadcast is registered as a channel of
+ * the fused SpillPlan, which walks the spill once for all variables.
+ * Variables with a form taking the KinematicSummary of the interaction are
+ * evaluated on the summary cached by the plan (see SUMMARY_VAR); the same
+ * holds for the other interaction-level macros below.
  * @param NAME of the resulting SpillMultiVar.
  * @param VAR function to broadcast over the interactions.
  * @param SEL function to select interactions.
  * @return a vector with the result of VAR called on each interaction passing
  * the cut SEL.
 */
-#define VARDLP_RECO(NAME,VAR,SEL)                             \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)  \
-    {                                                         \
-        std::vector<double> var;                              \
-        for(auto const& i : sr->dlp)                          \
-        {                                                     \
-            if(SEL(i))                                        \
-                var.push_back(VAR(i));                        \
-        }                                                     \
-        return var;                                           \
-    })
+#define VARDLP_RECO(NAME,VAR,SEL)                                                                        \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco([](const caf::SRSpillProxy* sr,              \
+                                                               const caf::SRInteractionDLPProxy& i,      \
+                                                               size_t k, std::vector<double>& var)       \
+    {                                                                                                    \
+        SpillPlan & plan(SpillPlan::instance());                                                         \
+        if(SELECT_RECO(SEL, plan, sr, k))                                                                \
+            var.push_back(INSTRUMENT_VAR(VAR, SUMMARY_VAR(VAR, i, plan.summaries.reco_summary(sr, k)))); \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true interactions. The SpillMultiVar
@@ -46,23 +75,22 @@
  * @return a vector with the result of VAR called on each interaction passing
  * the cut SEL.
 */
-#define VARDLP_TRUE(NAME,VAR,SEL)                             \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)  \
-    {                                                         \
-        std::vector<double> var;                              \
-        for(auto const& i : sr->dlp_true)                     \
-        {                                                     \
-            if(SEL(i))                                        \
-                var.push_back(VAR(i));                        \
-        }                                                     \
-        return var;                                           \
-    })
+#define VARDLP_TRUE(NAME,VAR,SEL)                                                                        \
+    const SpillMultiVar NAME(SpillPlan::instance().add_true([](const caf::SRSpillProxy* sr,              \
+                                                               const caf::SRInteractionTruthDLPProxy& i, \
+                                                               size_t k, std::vector<double>& var)       \
+    {                                                                                                    \
+        SpillPlan & plan(SpillPlan::instance());                                                         \
+        if(SELECT_TRUE(SEL, plan, sr, k))                                                                \
+            var.push_back(INSTRUMENT_VAR(VAR, SUMMARY_VAR(VAR, i, plan.summaries.true_summary(sr, k)))); \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true interactions and broadcasting a
  * SpillMultiVar over the matched (truth->reco) interaction. The SpillMultiVar
  * accepts a vector as a result of some function running over the top-level
- * StandardRecord.
+ * StandardRecord. The matched pairs come from the per-spill PairTable, on
+ * which VAR is evaluated at most once per pair.
  * @param NAME of the resulting SpillMultiVar.
  * @param VAR function to broadcast over the reco interactions.
  * @param CAT function that defines the truth category.
@@ -71,17 +99,15 @@
  * passing SEL that is matched to by the true interaction passing category
  * cut CAT.
 */
-#define VARDLP_TTP(NAME,VAR,CAT,SEL)                                     \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)             \
-    {                                                                    \
-        std::vector<double> var;                                         \
-        for(auto const& i : sr->dlp_true)                                \
-        {                                                                \
-            if(CAT(i) && i.match.size() > 0 && SEL(sr->dlp[i.match[0]])) \
-                var.push_back(VAR(sr->dlp[i.match[0]]));                 \
-        }                                                                \
-        return var;                                                      \
-    })
+#define VARDLP_TTP(NAME,VAR,CAT,SEL)                                                                                                                                   \
+    const SpillMultiVar NAME(SpillPlan::instance().add_pair([](const caf::SRSpillProxy* sr,                                                                            \
+                                                               const PairTable::Pair& m,                                                                               \
+                                                               size_t p, std::vector<double>& var)                                                                     \
+    {                                                                                                                                                                  \
+        SpillPlan & plan(SpillPlan::instance());                                                                                                                       \
+        if(SELECT_TRUE(CAT, plan, sr, m.truth) && SELECT_RECO(SEL, plan, sr, m.reco))                                                                                  \
+            var.push_back(INSTRUMENT_VAR(VAR, plan.pair_table.reco_value<VAR>(p, [&]() { return SUMMARY_VAR(VAR, *m.r, plan.summaries.reco_summary(sr, m.reco)); }))); \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over reco interactions which match to
@@ -96,24 +122,24 @@
  * passing SEL that is matched to by the true interaction passing category
  * cut CAT.
 */
-#define VARDLP_PTT(NAME,VAR,CAT,SEL)                                          \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)                  \
-    {                                                                         \
-        std::vector<double> var;                                              \
-        for(auto const& i : sr->dlp)                                          \
-        {                                                                     \
-            if(SEL(i) && i.match.size() > 0 && CAT(sr->dlp_true[i.match[0]])) \
-                var.push_back(VAR(i));                                        \
-        }                                                                     \
-        return var;                                                           \
-    })
+#define VARDLP_PTT(NAME,VAR,CAT,SEL)                                                                                                                          \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco([](const caf::SRSpillProxy* sr,                                                                   \
+                                                               const caf::SRInteractionDLPProxy& i,                                                           \
+                                                               size_t k, std::vector<double>& var)                                                            \
+    {                                                                                                                                                         \
+        SpillPlan & plan(SpillPlan::instance());                                                                                                              \
+        if(SELECT_RECO(SEL, plan, sr, k) && i.match.size() > 0 && SELECT_TRUE(CAT, plan, sr, i.match[0]))                                                     \
+            var.push_back(INSTRUMENT_VAR(VAR, SUMMARY_VAR(VAR, i, plan.summaries.reco_summary(sr, k))));                                                      \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true interactions and broadcasting a
  * SpillMultiVar over the matched (truth->reco) interaction. The SpillMultiVar
  * accepts a vector as a result of some function running over the top-level
  * StandardRecord. This wrapper will calculate the bias between two variables
- * between truth and reco.
+ * between truth and reco. The matched pairs come from the per-spill
+ * PairTable, on which TVAR and RVAR are evaluated at most once per pair and
+ * shared by all bias variables.
  * @param NAME of the resulting SpillMultiVar.
  * @param TVAR function to broadcast over the true interactions.
  * @param RVAR function to broadcast over the reco interactions.
@@ -123,24 +149,48 @@
  * interactions passing SEL that are matched to by the true interaction passing
  * category cut CAT.
 */
-#define VARDLP_BIAS(NAME,TVAR,RVAR,CAT,SEL)                                     \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)                    \
-    {                                                                           \
-        std::vector<double> var;                                                \
-        for(auto const& i : sr->dlp_true)                                       \
-        {                                                                       \
-            if(CAT(i) && i.match.size() > 0 && SEL(sr->dlp[i.match[0]]))        \
-                var.push_back((RVAR(sr->dlp[i.match[0]]) - TVAR(i)) / TVAR(i)); \
-        }                                                                       \
-        return var;                                                             \
-    })
+#define VARDLP_BIAS(NAME,TVAR,RVAR,CAT,SEL)                                                                                                                                         \
+    const SpillMultiVar NAME(SpillPlan::instance().add_pair([](const caf::SRSpillProxy* sr,                                                                                         \
+                                                               const PairTable::Pair& m,                                                                                            \
+                                                               size_t p, std::vector<double>& var)                                                                                  \
+    {                                                                                                                                                                               \
+        SpillPlan & plan(SpillPlan::instance());                                                                                                                                    \
+        if(SELECT_TRUE(CAT, plan, sr, m.truth) && SELECT_RECO(SEL, plan, sr, m.reco))                                                                                               \
+        {                                                                                                                                                                           \
+            double t(INSTRUMENT_VAR(TVAR, plan.pair_table.true_value<TVAR>(p, [&]() { return SUMMARY_VAR(TVAR, *m.t, plan.summaries.true_summary(sr, m.truth)); })));               \
+            var.push_back((INSTRUMENT_VAR(RVAR, plan.pair_table.reco_value<RVAR>(p, [&]() { return SUMMARY_VAR(RVAR, *m.r, plan.summaries.reco_summary(sr, m.reco)); })) - t) / t); \
+        }                                                                                                                                                                           \
+    }, #NAME))
+
+/**
+ * Preprocessor wrapper for a kinematic column (see ParticleBatch) of the reco
+ * interactions, read at the leading muon, the leading proton, or the pair of
+ * both. The column is computed once per spill for all reco particles by the
+ * batch kernels in batch_kernels.h and shared by all variables using it.
+ * @param NAME of the resulting SpillMultiVar.
+ * @param COLUMN the ParticleBatch column (e.g. kTransverseMomentum).
+ * @param ELEMENT the ParticleBatch element (e.g. kLeadingMuon).
+ * @param SEL function to select interactions.
+ * @return a vector with the value of COLUMN at ELEMENT for each interaction
+ * passing the cut SEL.
+*/
+#define VARDLP_RECO_BATCH(NAME,COLUMN,ELEMENT,SEL)                                                                              \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco([](const caf::SRSpillProxy* sr,                                     \
+                                                               const caf::SRInteractionDLPProxy&,                               \
+                                                               size_t k, std::vector<double>& var)                              \
+    {                                                                                                                           \
+        SpillPlan & plan(SpillPlan::instance());                                                                                \
+        if(SELECT_RECO(SEL, plan, sr, k))                                                                                       \
+            var.push_back(INSTRUMENT_VAR(COLUMN, plan.reco_batch(sr).value(ParticleBatch::COLUMN, k, ParticleBatch::ELEMENT))); \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true particles and broadcasting a
  * SpillMultiVar over the matched (truth->reco) particle. The SpillMultiVar
  * accepts a vector as a result of some function running over the top-level
  * StandardRecord. This wrapper will calculate the bias between two variables
- * between truth and reco.
+ * between truth and reco. Matched reco particles are found through the
+ * per-spill ParticleIndex shared by all such variables.
  * @param NAME of the resulting SpillMultiVar.
  * @param TVAR function to broadcast over the true particles.
  * @param RVAR function to broadcast over the reco particles.
@@ -151,26 +201,19 @@
  * particles passing SEL that are matched to by the true particle passing
  * category cut CAT.
 */
-#define PVARDLP_BIAS(NAME,TVAR,RVAR,ICAT,PCAT,SEL)                                               \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)                                     \
-    {                                                                                            \
-        std::vector<double> var;                                                                 \
-        std::map<caf::Proxy<int64_t>, const caf::Proxy<caf::SRParticleDLP> *> reco_particles;    \
-        for(auto const& i : sr->dlp)                                                             \
-        {                                                                                        \
-            for(auto const& p : i.particles)                                                     \
-                reco_particles.insert(std::make_pair(p.id, &p));                                 \
-        }                                                                                        \
-        for(auto const& i : sr->dlp_true)                                                        \
-        {                                                                                        \
-            for(auto const& p : i.particles)                                                     \
-            {                                                                                    \
-                if(ICAT(i) && PCAT(p) && p.match.size() > 0 && SEL(*reco_particles[p.match[0]])) \
-                    var.push_back((RVAR(*reco_particles[p.match[0]]) - TVAR(p)) / TVAR(p));      \
-            }                                                                                    \
-        }                                                                                        \
-        return var;                                                                              \
-    })
+#define PVARDLP_BIAS(NAME,TVAR,RVAR,ICAT,PCAT,SEL)                                                                               \
+    const SpillMultiVar NAME(SpillPlan::instance().add_true_particle([](const caf::SRSpillProxy* sr,                             \
+                                                                        const caf::SRInteractionTruthDLPProxy& i,                \
+                                                                        const caf::SRParticleTruthDLPProxy& p,                   \
+                                                                        std::vector<double>& var)                                \
+    {                                                                                                                            \
+        if(INSTRUMENT_CUT(ICAT, ICAT(i)) && INSTRUMENT_CUT(PCAT, PCAT(p)) && p.match.size() > 0)                                 \
+        {                                                                                                                        \
+            const caf::SRParticleDLPProxy * r(SpillPlan::instance().particle_index.find(sr, p.match[0]));                        \
+            if(r != nullptr && INSTRUMENT_CUT(SEL, SEL(*r)))                                                                     \
+                var.push_back((INSTRUMENT_VAR(RVAR, RVAR(*r)) - INSTRUMENT_VAR(TVAR, TVAR(p))) / INSTRUMENT_VAR(TVAR, TVAR(p))); \
+        }                                                                                                                        \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over reco particles. The SpillMultiVar
@@ -183,20 +226,15 @@
  * @return a vector with the result of VAR called on each particle passing
  * the cut SEL.
 */
-#define PVARDLP_RECO(NAME,VAR,SEL)                            \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)  \
-    {                                                         \
-        std::vector<double> var;                              \
-        for(auto const& i : sr->dlp)                          \
-        {                                                     \
-            for(auto const& p : i.particles)                  \
-            {                                                 \
-                if(SEL(p))                                    \
-                    var.push_back(VAR(p));                    \
-            }                                                 \
-        }                                                     \
-        return var;                                           \
-    })
+#define PVARDLP_RECO(NAME,VAR,SEL)                                                                           \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco_particle([](const caf::SRSpillProxy* sr,         \
+                                                                        const caf::SRInteractionDLPProxy& i, \
+                                                                        const caf::SRParticleDLPProxy& p,    \
+                                                                        std::vector<double>& var)            \
+    {                                                                                                        \
+        if(INSTRUMENT_CUT(SEL, SEL(p)))                                                                      \
+            var.push_back(INSTRUMENT_VAR(VAR, VAR(p)));                                                      \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true particles. The SpillMultiVar
@@ -210,26 +248,22 @@
  * @return a vector with the result of VAR called on each particle passing
  * the cut SEL.
 */
-#define PVARDLP_TRUE(NAME,VAR,ISEL,PSEL)                      \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)  \
-    {                                                         \
-        std::vector<double> var;                              \
-        for(auto const& i : sr->dlp_true)                     \
-        {                                                     \
-            for(auto const& p : i.particles)                  \
-            {                                                 \
-                if(ISEL(i) && PSEL(p))                        \
-                    var.push_back(VAR(p));                    \
-            }                                                 \
-        }                                                     \
-        return var;                                           \
-    })
+#define PVARDLP_TRUE(NAME,VAR,ISEL,PSEL)                                                                          \
+    const SpillMultiVar NAME(SpillPlan::instance().add_true_particle([](const caf::SRSpillProxy* sr,              \
+                                                                        const caf::SRInteractionTruthDLPProxy& i, \
+                                                                        const caf::SRParticleTruthDLPProxy& p,    \
+                                                                        std::vector<double>& var)                 \
+    {                                                                                                             \
+        if(INSTRUMENT_CUT(ISEL, ISEL(i)) && INSTRUMENT_CUT(PSEL, PSEL(p)))                                        \
+            var.push_back(INSTRUMENT_VAR(VAR, VAR(p)));                                                           \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true particles and broadcasting a
  * SpillMultiVar over the matched (truth->reco) particle. The SpillMultiVar
  * accepts a vector as a result of some function running over the top-level
- * StandardRecord.
+ * StandardRecord. Matched reco particles are found through the per-spill
+ * ParticleIndex shared by all such variables.
  * @param NAME of the resulting SpillMultiVar.
  * @param VAR function to broadcast over the reco particles.
  * @param ICAT function that defines the truth category (interactions).
@@ -239,26 +273,19 @@
  * passing SEL that is matched to by the true particle passing category
  * cut CAT.
 */
-#define PVAR_TTP(NAME,VAR,ICAT,PCAT,SEL)                                                         \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)                                     \
-    {                                                                                            \
-        std::vector<double> var;                                                                 \
-        std::map<caf::Proxy<int64_t>, const caf::Proxy<caf::SRParticleDLP> *> reco_particles;    \
-        for(auto const& i : sr->dlp)                                                             \
-        {                                                                                        \
-            for(auto const& p : i.particles)                                                     \
-                reco_particles.insert(std::make_pair(p.id, &p));                                 \
-        }                                                                                        \
-        for(auto const& i : sr->dlp_true)                                                        \
-        {                                                                                        \
-            for(auto const& p : i.particles)                                                     \
-            {                                                                                    \
-                if(ICAT(i) && PCAT(p) && p.match.size() > 0 && SEL(*reco_particles[p.match[0]])) \
-                    var.push_back(VAR(*reco_particles[p.match[0]]));                             \
-            }                                                                                    \
-        }                                                                                        \
-        return var;                                                                              \
-    })
+#define PVAR_TTP(NAME,VAR,ICAT,PCAT,SEL)                                                                          \
+    const SpillMultiVar NAME(SpillPlan::instance().add_true_particle([](const caf::SRSpillProxy* sr,              \
+                                                                        const caf::SRInteractionTruthDLPProxy& i, \
+                                                                        const caf::SRParticleTruthDLPProxy& p,    \
+                                                                        std::vector<double>& var)                 \
+    {                                                                                                             \
+        if(INSTRUMENT_CUT(ICAT, ICAT(i)) && INSTRUMENT_CUT(PCAT, PCAT(p)) && p.match.size() > 0)                  \
+        {                                                                                                         \
+            const caf::SRParticleDLPProxy * r(SpillPlan::instance().particle_index.find(sr, p.match[0]));         \
+            if(r != nullptr && INSTRUMENT_CUT(SEL, SEL(*r)))                                                      \
+                var.push_back(INSTRUMENT_VAR(VAR, VAR(*r)));                                                      \
+        }                                                                                                         \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over true interactions which match to a
@@ -271,17 +298,15 @@
  * @return a vector containing the results of VAR called on each true
  * interaction which is matched to a reco interaction of the specified category.
 */
-#define VARDLP_TCAT(NAME,VAR,SEL)                              \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)   \
-    {                                                          \
-        std::vector<double> var;                               \
-        for(auto const& i : sr->dlp_true)                      \
-        {                                                      \
-            if(i.match.size() > 0 && SEL(sr->dlp[i.match[0]])) \
-                var.push_back(VAR(i));                         \
-        }                                                      \
-        return var;                                            \
-    })
+#define VARDLP_TCAT(NAME,VAR,SEL)                                                                                                                                       \
+    const SpillMultiVar NAME(SpillPlan::instance().add_pair([](const caf::SRSpillProxy* sr,                                                                             \
+                                                               const PairTable::Pair& m,                                                                                \
+                                                               size_t p, std::vector<double>& var)                                                                      \
+    {                                                                                                                                                                   \
+        SpillPlan & plan(SpillPlan::instance());                                                                                                                        \
+        if(SELECT_RECO(SEL, plan, sr, m.reco))                                                                                                                          \
+            var.push_back(INSTRUMENT_VAR(VAR, plan.pair_table.true_value<VAR>(p, [&]() { return SUMMARY_VAR(VAR, *m.t, plan.summaries.true_summary(sr, m.truth)); }))); \
+    }, #NAME))
 
 /**
  * Preprocessor wrapper for looping over reco interactions which match to a
@@ -294,17 +319,68 @@
  * @return a vector containing the results of VAR called on each true
  * interaction which is matched to by a reco interaction of the specified category.
 */
-#define VARDLP_RCAT(NAME,VAR,SEL)                                                  \
-    const SpillMultiVar NAME([](const caf::SRSpillProxy* sr)                       \
-    {                                                                              \
-        std::vector<double> var;                                                   \
-        for(auto const& i : sr->dlp)                                               \
-        {                                                                          \
-            if(SEL(i) && i.match.size() > 0)                                       \
-                var.push_back(VAR(sr->dlp_true[i.match[0]]));                      \
-        }                                                                          \
-        return var;                                                                \
-    })
+#define VARDLP_RCAT(NAME,VAR,SEL)                                                                                                        \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco([](const caf::SRSpillProxy* sr,                                              \
+                                                               const caf::SRInteractionDLPProxy& i,                                      \
+                                                               size_t k, std::vector<double>& var)                                       \
+    {                                                                                                                                    \
+        SpillPlan & plan(SpillPlan::instance());                                                                                         \
+        if(SELECT_RECO(SEL, plan, sr, k) && i.match.size() > 0)                                                                          \
+            var.push_back(INSTRUMENT_VAR(VAR, SUMMARY_VAR(VAR, sr->dlp_true[i.match[0]], plan.summaries.true_summary(sr, i.match[0])))); \
+    }, #NAME))
+
+/**
+ * Preprocessor wrapper for evaluating a cut flow on each reco interaction.
+ * The SpillMultiVar accepts a vector as a result of some function running
+ * over the top-level StandardRecord.
+ * @param NAME of the SpillMultiVar.
+ * @param FLOW the CutFlow to evaluate.
+ * @return a vector containing the highest stage of FLOW reached by each reco
+ * interaction.
+*/
+#define VARDLP_FLOW(NAME,FLOW)                                                                      \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco([](const caf::SRSpillProxy* sr,         \
+                                                               const caf::SRInteractionDLPProxy& i, \
+                                                               size_t k, std::vector<double>& var)  \
+    {                                                                                               \
+        var.push_back(FLOW::evaluate(SpillPlan::instance().cache, sr, k));                          \
+    }, #NAME))
+
+/**
+ * Preprocessor wrapper for evaluating a cut flow on the reco interaction
+ * matched to each true interaction. Pairs with VARDLP_TCAT(..., cuts::no_cut)
+ * to produce the selection statistics (efficiency) of every stage at once.
+ * @param NAME of the SpillMultiVar.
+ * @param FLOW the CutFlow to evaluate.
+ * @return a vector containing the highest stage of FLOW reached by the reco
+ * interaction matched to each (matched) true interaction.
+*/
+#define VARDLP_FLOW_TTP(NAME,FLOW)                                                                  \
+    const SpillMultiVar NAME(SpillPlan::instance().add_pair([](const caf::SRSpillProxy* sr,         \
+                                                               const PairTable::Pair& m,            \
+                                                               size_t p, std::vector<double>& var)  \
+    {                                                                                               \
+        var.push_back(FLOW::evaluate(SpillPlan::instance().cache, sr, m.reco));                     \
+    }, #NAME))
+
+/**
+ * Preprocessor wrapper for evaluating a cut flow on each reco interaction
+ * which is matched to a true interaction. Pairs with
+ * VARDLP_RCAT(..., cuts::no_cut) to produce the selection statistics (purity)
+ * of every stage at once.
+ * @param NAME of the SpillMultiVar.
+ * @param FLOW the CutFlow to evaluate.
+ * @return a vector containing the highest stage of FLOW reached by each
+ * (matched) reco interaction.
+*/
+#define VARDLP_FLOW_PTT(NAME,FLOW)                                                                  \
+    const SpillMultiVar NAME(SpillPlan::instance().add_reco([](const caf::SRSpillProxy* sr,         \
+                                                               const caf::SRInteractionDLPProxy& i, \
+                                                               size_t k, std::vector<double>& var)  \
+    {                                                                                               \
+        if(i.match.size() > 0)                                                                      \
+            var.push_back(FLOW::evaluate(SpillPlan::instance().cache, sr, k));                      \
+    }, #NAME))
 
 /**
  * Preprocessor macro for defining categorical variables for all cuts.
@@ -383,4 +459,16 @@
     VARDLP_RECO(NAME ## _1muNp,VAR,cuts::all_1muNp_data_cut);             \
     VARDLP_RECO(NAME ## _1muX,VAR,cuts::all_1muX_data_cut);               \
 
+/**
+ * Preprocessor macro for reading a kinematic column (see ParticleBatch) of
+ * the reco interactions passing the three main signal cuts.
+ * @param NAME (base) to assign to the variable.
+ * @param COLUMN the ParticleBatch column.
+ * @param ELEMENT the ParticleBatch element.
+*/
+#define RECO_SIGNAL_BATCH(NAME,COLUMN,ELEMENT)                                          \
+    VARDLP_RECO_BATCH(NAME ## _1mu1p,COLUMN,ELEMENT,cuts::all_1mu1p_data_cut);          \
+    VARDLP_RECO_BATCH(NAME ## _1muNp,COLUMN,ELEMENT,cuts::all_1muNp_data_cut);          \
+    VARDLP_RECO_BATCH(NAME ## _1muX,COLUMN,ELEMENT,cuts::all_1muX_data_cut);            \
+
 #endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+/**
+ * @file file_list.h
+ * @brief Header file defining the expansion of input file wildcards.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef FILE_LIST_H
+#define FILE_LIST_H
+
+#include <string>
+#include <vector>
+
+#include <glob.h>
+
+/**
+ * Expands a wildcard (e.g. "/pnfs/.../flat/*.flat.root") into the list of
+ * matching files.
+ * @param pattern the wildcard (or the name of a single file).
+ * @return the matching files in sorted order, or an empty list if nothing
+ * matches (e.g. a SAM definition).
+*/
+inline std::vector<std::string> glob_files(const std::string & pattern)
+{
+    std::vector<std::string> files;
+    glob_t matches;
+    if(glob(pattern.c_str(), 0, nullptr, &matches) == 0)
+    {
+        for(size_t i(0); i < matches.gl_pathc; ++i)
+            files.push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+    return files;
+}
+#endif
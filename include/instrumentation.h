@@ -0,0 +1,328 @@
+/**
+ * @file instrumentation.h
+ * @brief Header file defining an opt-in instrumentation layer for the cuts
+ * and variables evaluated through the macros in definitions.h.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+/**
+ * The instrumentation is compiled out unless INSTRUMENTATION is defined (e.g.
+ * with -DINSTRUMENTATION or a #define before the first include). When it is
+ * compiled out, INSTRUMENT_CUT(NAME,EXPR), INSTRUMENT_VAR(NAME,EXPR) and
+ * INSTRUMENT_SELECT(NAME,CACHED,EXPR) expand to EXPR and add no cost.
+*/
+#ifndef INSTRUMENTATION
+
+#define INSTRUMENT_CUT(NAME,EXPR) (EXPR)
+#define INSTRUMENT_VAR(NAME,EXPR) (EXPR)
+#define INSTRUMENT_SELECT(NAME,CACHED,EXPR) (EXPR)
+
+#else
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+/**
+ * Collects the number of calls, the number of passes (cuts only), and the
+ * cumulative time of each cut and variable evaluated through the macros in
+ * definitions.h. Entries are keyed by the name of the function (as written
+ * in the macro) and its kind, so the same function used by several
+ * variables is accumulated into a single entry. Cuts applied through the
+ * CutCache are paid for when the cut mask of an interaction is filled, so
+ * the primitive cuts are timed there (see cuts::cut_mask()). The lookups of
+ * the cached masks by the macros are recorded as selections, which carry
+ * the calls and passes of the selection but no time.
+*/
+struct Instrumentation
+{
+    /**
+     * The kind of instrumented function.
+    */
+    enum Kind { kCut, kVar, kSelection };
+
+    /**
+     * Accumulated statistics of one instrumented function.
+    */
+    struct Entry
+    {
+        std::string name;
+        Kind kind;
+        uint64_t calls;
+        uint64_t passes;
+        double nanoseconds;
+    };
+
+    std::vector<Entry> entries;
+
+    /**
+     * Access the (single) instrumentation shared by all macros.
+     * @return the global Instrumentation.
+    */
+    static Instrumentation & instance()
+    {
+        static Instrumentation instrumentation;
+        return instrumentation;
+    }
+
+    /**
+     * Registers an instrumented function. Registering the same function
+     * again returns the existing entry.
+     * @param name of the function.
+     * @param kind of the function (cut or variable).
+     * @return the index of the entry.
+    */
+    size_t add(const std::string & name, Kind kind)
+    {
+        for(size_t e(0); e < entries.size(); ++e)
+            if(entries[e].name == name && entries[e].kind == kind) return e;
+        entries.push_back(Entry{name, kind, 0, 0, 0});
+        return entries.size() - 1;
+    }
+
+    /**
+     * Records one call of an instrumented function.
+     * @param e the index of the entry.
+     * @param start the time at which the call started.
+     * @param pass the result of the call (cuts only).
+     * @return none.
+    */
+    void record(size_t e, std::chrono::steady_clock::time_point start, bool pass)
+    {
+        Entry & entry(entries[e]);
+        entry.nanoseconds += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        ++entry.calls;
+        entry.passes += pass;
+    }
+
+    /**
+     * Records one untimed call of an instrumented function (a selection
+     * applied through a cached cut mask).
+     * @param e the index of the entry.
+     * @param pass the result of the call.
+     * @return none.
+    */
+    void count(size_t e, bool pass)
+    {
+        Entry & entry(entries[e]);
+        ++entry.calls;
+        entry.passes += pass;
+    }
+
+    /**
+     * Resets the statistics of every entry (e.g. in a worker process, which
+     * inherits the statistics of its parent). The entries stay registered.
+     * @return none.
+    */
+    void reset()
+    {
+        for(Entry & entry : entries)
+        {
+            entry.calls = 0;
+            entry.passes = 0;
+            entry.nanoseconds = 0;
+        }
+    }
+
+    /**
+     * Short label of a kind, as written in the report and in the JSON.
+     * @param kind of the function.
+     * @return the label of the kind.
+    */
+    static const char* label(Kind kind)
+    {
+        return kind == kCut ? "cut" : (kind == kVar ? "var" : "sel");
+    }
+
+    /**
+     * Retrieves the entries sorted by decreasing cumulative time.
+     * @return the sorted entries.
+    */
+    std::vector<Entry> sorted() const
+    {
+        std::vector<Entry> result(entries);
+        std::stable_sort(result.begin(), result.end(), [](const Entry & a, const Entry & b) { return a.nanoseconds > b.nanoseconds; });
+        return result;
+    }
+
+    /**
+     * Writes the entries as a table sorted by decreasing cumulative time.
+     * @param out the stream to write to.
+     * @return none.
+    */
+    void report(std::ostream & out) const
+    {
+        std::vector<Entry> result(sorted());
+        double total(0);
+        size_t width(8);
+        for(const Entry & e : result)
+        {
+            total += e.nanoseconds;
+            width = std::max(width, e.name.size());
+        }
+
+        std::ostringstream table;
+        table << std::left << std::setw(width) << "Function" << std::right
+              << std::setw(6) << "Kind" << std::setw(14) << "Calls" << std::setw(10) << "Pass"
+              << std::setw(14) << "Total [ms]" << std::setw(12) << "ns/call" << std::setw(9) << "Share" << "\n";
+        table << std::fixed;
+        for(const Entry & e : result)
+        {
+            table << std::left << std::setw(width) << e.name << std::right
+                  << std::setw(6) << label(e.kind) << std::setw(14) << e.calls;
+            if(e.kind != kVar && e.calls > 0)
+                table << std::setw(10) << std::setprecision(4) << double(e.passes) / e.calls;
+            else
+                table << std::setw(10) << "-";
+            if(e.kind == kSelection)
+            {
+                table << std::setw(14) << "-" << std::setw(12) << "-" << std::setw(9) << "-" << "\n";
+                continue;
+            }
+            table << std::setw(14) << std::setprecision(3) << e.nanoseconds * 1e-6
+                  << std::setw(12) << std::setprecision(1) << (e.calls > 0 ? e.nanoseconds / e.calls : 0)
+                  << std::setw(8) << std::setprecision(1) << (total > 0 ? 100 * e.nanoseconds / total : 0) << "%\n";
+        }
+        out << table.str();
+    }
+
+    /**
+     * Escapes a string for use within a JSON string literal.
+     * @param s the string to escape.
+     * @return the escaped string.
+    */
+    static std::string escape(const std::string & s)
+    {
+        std::string result;
+        for(char c : s)
+        {
+            if(c == '"' || c == '\\') result += '\\';
+            result += c;
+        }
+        return result;
+    }
+
+    /**
+     * Writes the entries (sorted by decreasing cumulative time) as JSON.
+     * @param path of the output file.
+     * @return none.
+    */
+    void write_json(const std::string & path) const
+    {
+        std::ofstream out(path);
+        out << "{\n  \"entries\": [";
+        std::vector<Entry> result(sorted());
+        for(size_t n(0); n < result.size(); ++n)
+        {
+            const Entry & e(result[n]);
+            out << (n > 0 ? ",\n" : "\n")
+                << "    {\"name\": \"" << escape(e.name) << "\", \"kind\": \"" << label(e.kind) << "\""
+                << ", \"calls\": " << e.calls << ", \"passes\": " << e.passes
+                << ", \"nanoseconds\": " << std::fixed << std::setprecision(0) << e.nanoseconds << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    /**
+     * Adds the entries of a JSON file written by write_json() (e.g. by a
+     * worker process of a SpecContainer) to the entries of this
+     * instrumentation. Entries of the same function and kind are summed.
+     * @param path of the input file.
+     * @return true if the file was read.
+    */
+    bool merge_json(const std::string & path)
+    {
+        std::ifstream in(path);
+        if(!in)
+            return false;
+        std::string line;
+        while(std::getline(in, line))
+        {
+            size_t start(line.find("{\"name\": \""));
+            if(start == std::string::npos)
+                continue;
+            std::string name;
+            size_t c(start + 10);
+            for(; c < line.size() && line[c] != '"'; ++c)
+            {
+                if(line[c] == '\\') ++c;
+                name += line[c];
+            }
+            size_t k(line.find("\"kind\": \"", c) + 9);
+            Kind kind(line.compare(k, 3, "cut") == 0 ? kCut : (line.compare(k, 3, "sel") == 0 ? kSelection : kVar));
+            Entry & entry(entries[add(name, kind)]);
+            entry.calls += std::stoull(line.substr(line.find("\"calls\": ", c) + 9));
+            entry.passes += std::stoull(line.substr(line.find("\"passes\": ", c) + 10));
+            entry.nanoseconds += std::stod(line.substr(line.find("\"nanoseconds\": ", c) + 15));
+        }
+        return true;
+    }
+};
+
+/**
+ * Preprocessor wrapper instrumenting the evaluation of a cut.
+ * @param NAME of the cut (stringified for the report).
+ * @param EXPR the expression evaluating the cut.
+ * @return the result of EXPR.
+*/
+#define INSTRUMENT_CUT(NAME,EXPR)                                                                  \
+    ([&]() -> bool                                                                                 \
+    {                                                                                              \
+        static const size_t entry_(Instrumentation::instance().add(#NAME, Instrumentation::kCut)); \
+        std::chrono::steady_clock::time_point start_(std::chrono::steady_clock::now());            \
+        bool result_(EXPR);                                                                        \
+        Instrumentation::instance().record(entry_, start_, result_);                               \
+        return result_;                                                                            \
+    }())
+
+/**
+ * Preprocessor wrapper instrumenting a selection applied through the
+ * CutCache. If the selection is read from a cached cut mask, only its calls
+ * and passes are recorded (the time is recorded for the primitive cuts when
+ * the mask is filled). Otherwise the selection is timed as a cut.
+ * @param NAME of the selection (stringified for the report).
+ * @param CACHED constant expression, true if the selection is read from the
+ * cut mask (see CutCache::cached_reco()).
+ * @param EXPR the expression applying the selection.
+ * @return the result of EXPR.
+*/
+#define INSTRUMENT_SELECT(NAME,CACHED,EXPR)                                                                  \
+    ([&]() -> bool                                                                                           \
+    {                                                                                                        \
+        if constexpr (CACHED)                                                                                \
+        {                                                                                                    \
+            static const size_t entry_(Instrumentation::instance().add(#NAME, Instrumentation::kSelection)); \
+            bool result_(EXPR);                                                                              \
+            Instrumentation::instance().count(entry_, result_);                                              \
+            return result_;                                                                                  \
+        }                                                                                                    \
+        else                                                                                                 \
+            return INSTRUMENT_CUT(NAME, EXPR);                                                               \
+    }())
+
+/**
+ * Preprocessor wrapper instrumenting the evaluation of a variable.
+ * @param NAME of the variable (stringified for the report).
+ * @param EXPR the expression evaluating the variable.
+ * @return the result of EXPR.
+*/
+#define INSTRUMENT_VAR(NAME,EXPR)                                                                  \
+    ([&]() -> double                                                                               \
+    {                                                                                              \
+        static const size_t entry_(Instrumentation::instance().add(#NAME, Instrumentation::kVar)); \
+        std::chrono::steady_clock::time_point start_(std::chrono::steady_clock::now());            \
+        double result_(EXPR);                                                                      \
+        Instrumentation::instance().record(entry_, start_, true);                                  \
+        return result_;                                                                            \
+    }())
+
+#endif
+#endif
@@ -27,7 +27,7 @@ namespace vars
     template<class T>
         double transverse_momentum(const T & particle)
         {
-            if constexpr (std::is_same_v<T, caf::SRParticleTruthDLPProxy>)
+            if constexpr (is_truth_v<T>)
                 return std::sqrt(std::pow(particle.truth_momentum[0], 2) + std::pow(particle.truth_momentum[1], 2));
             else
                 return std::sqrt(std::pow(particle.momentum[0], 2) + std::pow(particle.momentum[1], 2));
@@ -42,7 +42,7 @@ namespace vars
     template<class T>
         double polar_angle(const T & particle)
         {
-            if constexpr (std::is_same_v<T, caf::SRParticleTruthDLPProxy>)
+            if constexpr (is_truth_v<T>)
                 return std::acos(particle.truth_start_dir[2]);
             else
                 return std::acos(particle.start_dir[2]);
@@ -57,75 +57,169 @@ namespace vars
     template<class T>
         double azimuthal_angle(const T & particle)
         {
-            if constexpr (std::is_same_v<T, caf::SRParticleTruthDLPProxy>)
+            if constexpr (is_truth_v<T>)
                 return std::acos(particle.truth_start_dir[0] / std::sqrt(std::pow(particle.truth_start_dir[0], 2) + std::pow(particle.truth_start_dir[1], 2)));
             else
                 return std::acos(particle.start_dir[0] / std::sqrt(std::pow(particle.start_dir[0], 2) + std::pow(particle.start_dir[1], 2)));
         }
 
     /**
-     * Methods for calculating the reconstructed variables for the numu analyses.
+     * Summary of the kinematic quantities of an interaction that are used by
+     * the numu variables. The summary is filled by a single pass over the
+     * particles of the interaction (see summarize()), after which each of the
+     * numu variables is an O(1) accessor.
     */
+    struct KinematicSummary
+    {
+        size_t leading_muon;
+        size_t leading_proton;
+        cuts::topology_t topology;
+        double visible_energy;
+        double primary_px;
+        double primary_py;
+        double signal_px;
+        double signal_py;
+        double signal_lepton_px;
+        double signal_lepton_py;
+        double signal_muon_px;
+        double signal_muon_py;
+        double signal_hadron_px;
+        double signal_hadron_py;
+    };
 
     /**
-     * Variable for total visible energy of interaction.
+     * Computes the kinematic summary of an interaction in one pass over its
+     * particles. The leading particles follow leading_particle_index(), the
+     * topology follows cuts::count_primaries(), and the momentum sums are
+     * accumulated in particle order.
      * @tparam T the type of interaction (true or reco).
-     * @param interaction to apply the variable on.
-     * @return the total visible energy of the interaction.
+     * @param interaction to summarize.
+     * @return the kinematic summary of the interaction.
     */
     template<class T>
-        double visible_energy(const T & interaction)
+        KinematicSummary summarize(const T & interaction)
         {
-            double energy(0);
-            for(const auto & p : interaction.particles)
+            KinematicSummary s{};
+            double muon_ke(0), proton_ke(0);
+            for(size_t i(0); i < interaction.particles.size(); ++i)
             {
+                const auto & p = interaction.particles[i];
+                int pid(p.pid);
+                double energy(csda_ke(p));
+                if constexpr (is_truth_v<T>)
+                    energy = ke_init(p);
+                if(pid == 2 && energy > muon_ke)
+                {
+                    muon_ke = energy;
+                    s.leading_muon = i;
+                }
+                else if(pid == 4 && energy > proton_ke)
+                {
+                    proton_ke = energy;
+                    s.leading_proton = i;
+                }
+
+                float px, py;
+                if constexpr (is_truth_v<T>)
+                {
+                    px = p.truth_momentum[0];
+                    py = p.truth_momentum[1];
+                }
+                else
+                {
+                    px = p.momentum[0];
+                    py = p.momentum[1];
+                }
+
                 if(p.is_primary)
                 {
-                    if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
+                    if constexpr (is_truth_v<T>)
+                    {
+                        s.visible_energy += p.energy_deposit;
+                    }
+                    else
+                    {
+                        if(pid < 2) s.visible_energy += p.calo_ke;
+                        else s.visible_energy += p.csda_ke;
+                    }
+                    if(pid == 2) s.visible_energy += MUON_MASS;
+                    else if(pid == 3) s.visible_energy += PION_MASS;
+                    s.primary_px += px;
+                    s.primary_py += py;
+                }
+
+                if(cuts::final_state_signal(p))
+                {
+                    if(pid >= 0 && pid < 5)
+                        s.topology = cuts::topology_increment(s.topology, pid);
+                    if(pid > 2)
                     {
-                        energy += p.energy_deposit;
+                        s.signal_hadron_px += px;
+                        s.signal_hadron_py += py;
                     }
                     else
                     {
-                        if(p.pid < 2) energy += p.calo_ke;
-                        else energy += p.csda_ke;
+                        s.signal_lepton_px += px;
+                        s.signal_lepton_py += py;
+                        if(pid == 2)
+                        {
+                            s.signal_muon_px += px;
+                            s.signal_muon_py += py;
+                        }
                     }
-                    if(p.pid == 2) energy += MUON_MASS;
-                    else if(p.pid == 3) energy += PION_MASS;
+                    s.signal_px += px;
+                    s.signal_py += py;
                 }
             }
-            return energy;
+            return s;
         }
 
+    /**
+     * Methods for calculating the reconstructed variables for the numu
+     * analyses. Each variable is available as an accessor on a precomputed
+     * KinematicSummary of the interaction, and as a convenience overload
+     * taking only the interaction (which summarizes it first).
+    */
+
+    /**
+     * Variable for total visible energy of interaction.
+     * @tparam T the type of interaction (true or reco).
+     * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
+     * @return the total visible energy of the interaction.
+    */
+    template<class T>
+        double visible_energy(const T & /*interaction*/, const KinematicSummary & s) { return s.visible_energy; }
+
     /**
      * Variable for finding the leading muon kinetic energy.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the kinetic energy of the leading muon.
     */
     template<class T>
-        double leading_muon_ke(const T & interaction)
+        double leading_muon_ke(const T & interaction, const KinematicSummary & s)
         {
-            size_t i(leading_particle_index(interaction, 2));
-            double energy(csda_ke(interaction.particles[i]));
-            if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                energy = ke_init(interaction.particles[i]);
+            double energy(csda_ke(interaction.particles[s.leading_muon]));
+            if constexpr (is_truth_v<T>)
+                energy = ke_init(interaction.particles[s.leading_muon]);
             return energy;
         }
-    
+
     /**
      * Variable for finding the leading proton kinetic energy.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
-     * @return the kinetic energy of the leading muon.
+     * @param s the kinematic summary of the interaction.
+     * @return the kinetic energy of the leading proton.
     */
     template<class T>
-        double leading_proton_ke(const T & interaction)
+        double leading_proton_ke(const T & interaction, const KinematicSummary & s)
         {
-            size_t i(leading_particle_index(interaction, 4));
-            double energy(csda_ke(interaction.particles[i]));
-            if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                energy = ke_init(interaction.particles[i]);
+            double energy(csda_ke(interaction.particles[s.leading_proton]));
+            if constexpr (is_truth_v<T>)
+                energy = ke_init(interaction.particles[s.leading_proton]);
             return energy;
         }
 
@@ -133,140 +227,86 @@ namespace vars
      * Variable for the transverse momentum of the leading muon.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the transverse momentum of the leading muon.
     */
     template<class T>
-        double leading_muon_pt(const T & interaction)
-        {
-            size_t i(leading_particle_index(interaction, 2));
-            return transverse_momentum(interaction.particles[i]);
-        }
+        double leading_muon_pt(const T & interaction, const KinematicSummary & s) { return transverse_momentum(interaction.particles[s.leading_muon]); }
 
     /**
      * Variable for the transverse momentum of the leading proton.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the transverse momentum of the leading proton.
     */
     template<class T>
-        double leading_proton_pt(const T & interaction)
-        {
-            size_t i(leading_particle_index(interaction, 4));
-            return transverse_momentum(interaction.particles[i]);
-        }
+        double leading_proton_pt(const T & interaction, const KinematicSummary & s) { return transverse_momentum(interaction.particles[s.leading_proton]); }
 
     /**
      * Variable for the muon polar angle.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the polar angle of the leading muon.
     */
     template<class T>
-        double muon_polar_angle(const T & interaction)
-        {
-            size_t i(leading_particle_index(interaction, 2));
-            return polar_angle(interaction.particles[i]);
-        }
+        double muon_polar_angle(const T & interaction, const KinematicSummary & s) { return polar_angle(interaction.particles[s.leading_muon]); }
 
     /**
      * Variable for the muon azimuthal angle.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the azimuthal angle of the leading muon.
-     */
+    */
     template<class T>
-        double muon_azimuthal_angle(const T & interaction)
-        {
-            size_t i(leading_particle_index(interaction, 2));
-            return azimuthal_angle(interaction.particles[i]);
-        }
+        double muon_azimuthal_angle(const T & interaction, const KinematicSummary & s) { return azimuthal_angle(interaction.particles[s.leading_muon]); }
 
     /**
      * Variable for the opening angle between leading muon and
      * proton.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the opening angle between the leading muon and
      * proton.
     */
     template<class T>
-        double opening_angle(const T & interaction)
+        double opening_angle(const T & interaction, const KinematicSummary & s)
         {
-            auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
-            auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
-            if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
+            const auto & m(interaction.particles[s.leading_muon]);
+            const auto & p(interaction.particles[s.leading_proton]);
+            if constexpr (is_truth_v<T>)
                 return std::acos(m.truth_start_dir[0] * p.truth_start_dir[0] + m.truth_start_dir[1] * p.truth_start_dir[1] + m.truth_start_dir[2] * p.truth_start_dir[2]);
             else
                 return std::acos(m.start_dir[0] * p.start_dir[0] + m.start_dir[1] * p.start_dir[1] + m.start_dir[2] * p.start_dir[2]);
         }
-    
+
     /**
      * Variable for the transverse momentum of the interaction.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the transverse momentum of the primary particles.
     */
     template<class T>
-        double interaction_pt(const T & interaction)
+        double interaction_pt(const T & /*interaction*/, const KinematicSummary & s)
         {
-            double px(0), py(0);
-            for(const auto & p : interaction.particles)
-                if(p.is_primary)
-                {
-                    if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                    {
-                        px += p.truth_momentum[0];
-                        py += p.truth_momentum[1];
-                    }
-                    else
-                    {
-                        px += p.momentum[0];
-                        py += p.momentum[1];
-                    }
-                }
-            return std::sqrt(std::pow(px, 2) + std::pow(py, 2));
+            return std::sqrt(std::pow(s.primary_px, 2) + std::pow(s.primary_py, 2));
         }
 
     /**
      * Variable for phi_T of the interaction.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the phi_T of the interaction.
     */
     template<class T>
-        double phiT(const T & interaction)
+        double phiT(const T & /*interaction*/, const KinematicSummary & s)
         {
-            double lpx(0), lpy(0), hpx(0), hpy(0);
-            for(const auto & p : interaction.particles)
-                if(cuts::final_state_signal(p))
-                {
-                    if(p.pid > 2)
-                    {
-                        if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                        {
-                            hpx += p.truth_momentum[0];
-                            hpy += p.truth_momentum[1];
-                        }
-                        else
-                        {
-                            hpx += p.momentum[0];
-                            hpy += p.momentum[1];
-                        }
-                    }
-                    else if(p.pid == 2)
-                    {
-                        if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                        {
-                            lpx += p.truth_momentum[0];
-                            lpy += p.truth_momentum[1];
-                        }
-                        else
-                        {
-                            lpx += p.momentum[0];
-                            lpy += p.momentum[1];
-                        }
-                    }
-                }
+            double hpx(s.signal_hadron_px), hpy(s.signal_hadron_py), lpx(s.signal_muon_px), lpy(s.signal_muon_py);
             return std::acos((-hpx * lpx - hpy * lpy) / (std::sqrt(std::pow(hpx, 2) + std::pow(hpy, 2)) * std::sqrt(std::pow(lpx, 2) + std::pow(lpy, 2))));
         }
 
@@ -274,39 +314,13 @@ namespace vars
      * Variable for alpha_T of the interaction.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
-     * @return the phi_T of the interaction.
+     * @param s the kinematic summary of the interaction.
+     * @return the alpha_T of the interaction.
     */
     template<class T>
-        double alphaT(const T & interaction)
+        double alphaT(const T & /*interaction*/, const KinematicSummary & s)
         {
-            double lpx(0), lpy(0), px(0), py(0);
-            for(const auto & p : interaction.particles)
-                if(cuts::final_state_signal(p))
-                {
-                    if(p.pid <= 2)
-                    {
-                        if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                        {
-                            lpx += p.truth_momentum[0];
-                            lpy += p.truth_momentum[1];
-                        }
-                        else
-                        {
-                            lpx += p.momentum[0];
-                            lpy += p.momentum[1];
-                        }
-                    }
-                    if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
-                    {
-                        px += p.truth_momentum[0];
-                        py += p.truth_momentum[1];
-                    }
-                    else
-                    {
-                        px += p.momentum[0];
-                        py += p.momentum[1];
-                    }
-                }
+            double px(s.signal_px), py(s.signal_py), lpx(s.signal_lepton_px), lpy(s.signal_lepton_py);
             return std::acos((-px * lpx - py * lpy) / (std::sqrt(std::pow(px, 2) + std::pow(py, 2)) * std::sqrt(std::pow(lpx, 2) + std::pow(lpy, 2))));
         }
 
@@ -315,27 +329,46 @@ namespace vars
      * interaction.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the muon softmax score of the leading muon.
     */
     template<class T>
-        double muon_softmax(const T & interaction)
-        {
-            size_t i(leading_particle_index(interaction, 2));
-            return interaction.particles[i].pid_scores[2];
-        }
+        double muon_softmax(const T & interaction, const KinematicSummary & s) { return interaction.particles[s.leading_muon].pid_scores[2]; }
 
     /**
      * Variable for the proton softmax score for the leading proton of the
      * interaction.
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param s the kinematic summary of the interaction.
      * @return the proton softmax score of the leading proton.
     */
     template<class T>
-        double proton_softmax(const T & interaction)
-        {
-            size_t i(leading_particle_index(interaction, 4));
-            return interaction.particles[i].pid_scores[4];
-        }
+        double proton_softmax(const T & interaction, const KinematicSummary & s) { return interaction.particles[s.leading_proton].pid_scores[4]; }
+
+    /**
+     * Single-argument forms of the numu variables, suitable for use with the
+     * preprocessor macros in definitions.h. Each summarizes the interaction
+     * and forwards to the corresponding accessor. The macros themselves call
+     * the accessors with the summary cached per interaction and spill (see
+     * SummaryCache and SUMMARY_VAR), so the summary is computed only once
+     * for all the variables of an interaction.
+     * @tparam T the type of interaction (true or reco).
+     * @param interaction to apply the variable on.
+     * @return the value of the variable.
+    */
+    template<class T> double visible_energy(const T & interaction) { return visible_energy(interaction, summarize(interaction)); }
+    template<class T> double leading_muon_ke(const T & interaction) { return leading_muon_ke(interaction, summarize(interaction)); }
+    template<class T> double leading_proton_ke(const T & interaction) { return leading_proton_ke(interaction, summarize(interaction)); }
+    template<class T> double leading_muon_pt(const T & interaction) { return leading_muon_pt(interaction, summarize(interaction)); }
+    template<class T> double leading_proton_pt(const T & interaction) { return leading_proton_pt(interaction, summarize(interaction)); }
+    template<class T> double muon_polar_angle(const T & interaction) { return muon_polar_angle(interaction, summarize(interaction)); }
+    template<class T> double muon_azimuthal_angle(const T & interaction) { return muon_azimuthal_angle(interaction, summarize(interaction)); }
+    template<class T> double opening_angle(const T & interaction) { return opening_angle(interaction, summarize(interaction)); }
+    template<class T> double interaction_pt(const T & interaction) { return interaction_pt(interaction, summarize(interaction)); }
+    template<class T> double phiT(const T & interaction) { return phiT(interaction, summarize(interaction)); }
+    template<class T> double alphaT(const T & interaction) { return alphaT(interaction, summarize(interaction)); }
+    template<class T> double muon_softmax(const T & interaction) { return muon_softmax(interaction, summarize(interaction)); }
+    template<class T> double proton_softmax(const T & interaction) { return proton_softmax(interaction, summarize(interaction)); }
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,250 @@
+/**
+ * @file output_sink.h
+ * @brief Header file defining per-job and per-thread output file naming and
+ * a sharded text sink, so that several selection jobs (or threads) can write
+ * their outputs concurrently.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <mutex>
+#include <memory>
+#include <tuple>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <ostream>
+
+#include "async_writer.h"
+
+/**
+ * Retrieves the index of the current job, as set by the SELECTION_JOB
+ * environment variable (e.g. SELECTION_JOB=$PROCESS on the grid).
+ * @return the index of the job, or an empty string if SELECTION_JOB is not
+ * set.
+*/
+inline std::string job_index()
+{
+    const char * job(std::getenv("SELECTION_JOB"));
+    return job != nullptr ? std::string(job) : std::string();
+}
+
+/**
+ * Builds the name of an output file for the current job and a given shard.
+ * The job and shard indices are inserted before the extension, e.g.
+ * output.log becomes output.job3.shard1.log. The job index is omitted if
+ * SELECTION_JOB is not set and the shard index is omitted for shard 0, so a
+ * single-threaded job without SELECTION_JOB writes to the unchanged name.
+ * @param path the name of the output file.
+ * @param shard the index of the shard (e.g. the thread).
+ * @param job the index of the job (default: SELECTION_JOB).
+ * @return the name of the output file of the shard.
+*/
+inline std::string sink_path(const std::string & path, size_t shard = 0, const std::string & job = job_index())
+{
+    std::string suffix;
+    if(!job.empty())
+        suffix += ".job" + job;
+    if(shard > 0)
+        suffix += ".shard" + std::to_string(shard);
+    size_t slash(path.find_last_of('/'));
+    size_t dot(path.find_last_of('.'));
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + suffix;
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+/**
+ * Builds the job index of the k-th worker process started by the current
+ * job (see worker_pool.h), e.g. "3" or, if SELECTION_JOB=7, "7_3".
+ * @param k the index of the worker (the sample or the input file).
+ * @return the job index of the worker.
+*/
+inline std::string worker_job(size_t k)
+{
+    std::string job(job_index());
+    return (job.empty() ? std::string() : job + "_") + std::to_string(k);
+}
+
+/**
+ * Interface of the outputs that are written while the spectra are filled
+ * (the CSV logs and the row trees). Each instance registers itself on
+ * construction, so that forked worker processes can redirect all outputs to
+ * files of their own and the parent can collect them afterwards (see
+ * worker_pool.h).
+*/
+class WorkerSink
+{
+public:
+    WorkerSink() { registry().push_back(this); }
+    virtual ~WorkerSink() { registry().erase(std::remove(registry().begin(), registry().end(), this), registry().end()); }
+
+    /**
+     * Redirects the output to the files of the current SELECTION_JOB. Called
+     * in a forked worker process before anything is written; the files
+     * inherited from the parent process are abandoned.
+     * @return none.
+    */
+    virtual void reopen() = 0;
+
+    /**
+     * Writes the pending output and closes the files.
+     * @return none.
+    */
+    virtual void close() = 0;
+
+    /**
+     * Appends the (closed) output of a worker process to this output and
+     * removes the files of the worker.
+     * @param job the job index of the worker (see worker_job()).
+     * @return none.
+    */
+    virtual void merge(const std::string & job) = 0;
+
+    /**
+     * Builds the name of a file written by a worker process.
+     * @param job the job index of the worker (see worker_job()).
+     * @param shard the index of the file of the worker.
+     * @return the name of the file, or an empty string if the output has
+     * no such file.
+    */
+    virtual std::string output(const std::string & job, size_t shard) const = 0;
+
+    /**
+     * Retrieves the list of all registered outputs.
+     * @return the registered outputs.
+    */
+    static std::vector<WorkerSink *> & registry()
+    {
+        static std::vector<WorkerSink *> sinks;
+        return sinks;
+    }
+};
+
+/**
+ * Text output sink with one AsyncWriter (and one file) per thread. Each
+ * thread writes to its own shard, created on first use; shard 0 goes to the
+ * file of the first thread to write (see sink_path()). Rows written by
+ * different threads therefore never interleave. The shards can be combined
+ * with tools/merge_shards.py, which produces a deterministic row order.
+*/
+class ShardedWriter : public WorkerSink
+{
+public:
+    /**
+     * Constructor for ShardedWriter. Only the file of shard 0 is created;
+     * the others are created on first use by their thread.
+     * @param path the name of the output file (before the job and shard
+     * indices are inserted).
+    */
+    ShardedWriter(const std::string & path) : base(path), claimed(0), generation(0)
+    {
+        shards.push_back(std::make_unique<AsyncWriter>(sink_path(base)));
+    }
+
+    /**
+     * Retrieves the stream of the shard of the calling thread, creating it
+     * on first use.
+     * @return the AsyncWriter of the calling thread.
+    */
+    AsyncWriter & local()
+    {
+        thread_local std::vector<std::tuple<const ShardedWriter *, size_t, AsyncWriter *>> cache;
+        for(const auto & c : cache)
+            if(std::get<0>(c) == this && std::get<1>(c) == generation) return *std::get<2>(c);
+        std::lock_guard<std::mutex> lock(mutex);
+        if(claimed == shards.size())
+            shards.push_back(std::make_unique<AsyncWriter>(sink_path(base, shards.size())));
+        AsyncWriter * shard(shards[claimed++].get());
+        cache.emplace_back(this, generation, shard);
+        return *shard;
+    }
+
+    /**
+     * Starts a new set of shards in a forked worker process, named according
+     * to the current SELECTION_JOB. The shards inherited from the parent
+     * process are abandoned without being flushed or closed, as their
+     * background threads do not exist in the child.
+     * @return none.
+    */
+    void reopen() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(std::unique_ptr<AsyncWriter> & s : shards)
+            s.release();
+        shards.clear();
+        ++generation;
+        claimed = 0;
+        shards.push_back(std::make_unique<AsyncWriter>(sink_path(base)));
+    }
+
+    /**
+     * Closes all shards. The sink must not be written to afterwards.
+     * @return none.
+    */
+    void close() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const std::unique_ptr<AsyncWriter> & s : shards)
+            s->close();
+    }
+
+    /**
+     * Appends the shards of a worker process, in shard order, to the shard
+     * of the calling thread and removes them.
+     * @param job the job index of the worker (see worker_job()).
+     * @return none.
+    */
+    void merge(const std::string & job) override
+    {
+        AsyncWriter & stream(local());
+        for(size_t k(0); ; ++k)
+        {
+            std::string path(output(job, k));
+            std::ifstream input(path, std::ios::binary);
+            if(!input.is_open())
+                break;
+            if(input.peek() != std::ifstream::traits_type::eof())
+                stream << input.rdbuf();
+            input.close();
+            std::remove(path.c_str());
+        }
+    }
+
+    /**
+     * Builds the name of the file of a shard of a worker process.
+     * @param job the job index of the worker (see worker_job()).
+     * @param shard the index of the shard.
+     * @return the name of the file.
+    */
+    std::string output(const std::string & job, size_t shard) const override
+    {
+        return sink_path(base, shard, job);
+    }
+
+private:
+    std::string base;
+    size_t claimed;
+    size_t generation;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<AsyncWriter>> shards;
+};
+
+/**
+ * Writes to the shard of the calling thread, so a ShardedWriter can be used
+ * in place of a std::ostream (e.g. with the OUT and CSV macros).
+ * @tparam T the type of the value.
+ * @param sink the ShardedWriter to write to.
+ * @param value the value to write.
+ * @return the stream of the shard of the calling thread.
+*/
+template<class T>
+    std::ostream & operator<<(ShardedWriter & sink, const T & value)
+    {
+        return sink.local() << value;
+    }
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file pair_table.h
+ * @brief Header file defining a per-spill table of the matched (truth->reco)
+ * interaction pairs.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef PAIR_TABLE_H
+#define PAIR_TABLE_H
+
+#include <vector>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "cut_cache.h"
+
+/**
+ * Table of the true interactions of the spill that are matched to a reco
+ * interaction, paired with their (first) match. The table is built at most
+ * once per spill, on the first sweep over it, in the order of sr->dlp_true,
+ * and shared by all variables defined on matched pairs (see the VARDLP_TTP,
+ * VARDLP_BIAS, VARDLP_TCAT, and VARDLP_FLOW_TTP macros). The cut masks of
+ * both members of each pair are filled in the CutCache when the table is
+ * built. Interaction variables evaluated on the pairs are memoized per pair,
+ * so a variable shared by several channels (e.g. the true visible energy of
+ * the bias variables) is computed once per pair.
+*/
+struct PairTable
+{
+    /**
+     * A matched pair: the indices of the true and reco interactions within
+     * sr->dlp_true and sr->dlp, and the interactions themselves.
+    */
+    struct Pair
+    {
+        size_t truth;
+        size_t reco;
+        const caf::SRInteractionTruthDLPProxy * t;
+        const caf::SRInteractionDLPProxy * r;
+    };
+
+    std::vector<Pair> pairs;
+    std::vector<std::vector<double>> true_values;
+    std::vector<std::vector<double>> reco_values;
+    std::vector<std::vector<bool>> true_filled;
+    std::vector<std::vector<bool>> reco_filled;
+    bool built = false;
+
+    /**
+     * Invalidates the table for a new spill. The storage keeps its capacity.
+     * @return none.
+    */
+    void reset() { built = false; }
+
+    /**
+     * Builds the table from the true interactions of the spill, if it has
+     * not been built for this spill yet.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param cache the CutCache of the spill, in which the cut masks of the
+     * pairs are filled.
+     * @return the matched pairs.
+    */
+    const std::vector<Pair> & build(const caf::SRSpillProxy* sr, CutCache & cache)
+    {
+        if(built)
+            return pairs;
+        pairs.clear();
+        for(size_t k(0); k < sr->dlp_true.size(); ++k)
+        {
+            auto const& i = sr->dlp_true[k];
+            if(i.match.size() == 0)
+                continue;
+            size_t m(i.match[0]);
+            pairs.push_back({k, m, &i, &sr->dlp[m]});
+            cache.true_mask(sr, k);
+            cache.reco_mask(sr, m);
+        }
+        for(std::vector<bool> & f : true_filled)
+            f.assign(pairs.size(), false);
+        for(std::vector<bool> & f : reco_filled)
+            f.assign(pairs.size(), false);
+        built = true;
+        return pairs;
+    }
+
+    /**
+     * Evaluates a variable on the true interaction of a pair, once per pair
+     * and spill.
+     * @tparam F the variable.
+     * @tparam G the type of the function computing the value.
+     * @param p the index of the pair.
+     * @param compute the function computing the value of the variable on the
+     * true interaction of the pair (e.g. with its KinematicSummary).
+     * @return the value of the variable.
+    */
+    template<double (*F)(const caf::SRInteractionTruthDLPProxy &), class G>
+        double true_value(size_t p, const G & compute)
+        {
+            static const size_t s(true_slots()++);
+            return memoize(true_values, true_filled, s, p, compute);
+        }
+
+    /**
+     * Evaluates a variable on the reco interaction of a pair, once per pair
+     * and spill.
+     * @tparam F the variable.
+     * @tparam G the type of the function computing the value.
+     * @param p the index of the pair.
+     * @param compute the function computing the value of the variable on the
+     * reco interaction of the pair (e.g. with its KinematicSummary).
+     * @return the value of the variable.
+    */
+    template<double (*F)(const caf::SRInteractionDLPProxy &), class G>
+        double reco_value(size_t p, const G & compute)
+        {
+            static const size_t s(reco_slots()++);
+            return memoize(reco_values, reco_filled, s, p, compute);
+        }
+
+private:
+    /**
+     * Looks up the value of a variable on a pair, computing it on first use.
+     * @tparam G the type of the function computing the value.
+     * @param values the values of each variable (slot) on each pair.
+     * @param filled the flags of the values already computed.
+     * @param s the slot of the variable.
+     * @param p the index of the pair.
+     * @param compute the function computing the value.
+     * @return the value of the variable.
+    */
+    template<class G>
+        double memoize(std::vector<std::vector<double>> & values, std::vector<std::vector<bool>> & filled,
+                       size_t s, size_t p, const G & compute)
+        {
+            if(s >= values.size())
+            {
+                values.resize(s + 1);
+                filled.resize(s + 1);
+            }
+            if(filled[s].size() != pairs.size())
+                filled[s].assign(pairs.size(), false);
+            if(values[s].size() < pairs.size())
+                values[s].resize(pairs.size());
+            if(!filled[s][p])
+            {
+                values[s][p] = compute();
+                filled[s][p] = true;
+            }
+            return values[s][p];
+        }
+
+    /**
+     * Counter of the slots assigned to variables of true interactions.
+     * @return the number of slots assigned.
+    */
+    static size_t & true_slots()
+    {
+        static size_t n(0);
+        return n;
+    }
+
+    /**
+     * Counter of the slots assigned to variables of reco interactions.
+     * @return the number of slots assigned.
+    */
+    static size_t & reco_slots()
+    {
+        static size_t n(0);
+        return n;
+    }
+};
+#endif
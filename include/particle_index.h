@@ -0,0 +1,127 @@
+/**
+ * @file particle_index.h
+ * @brief Header file defining a per-spill lookup table from reco particle ID
+ * to reco particle.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef PARTICLE_INDEX_H
+#define PARTICLE_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+
+/**
+ * Flat lookup table from the ID of a reco particle to its position (the
+ * interaction index within sr->dlp and the particle index within that
+ * interaction). The table is built at most once per spill, on the first
+ * lookup, and shared by all particle-level truth-to-reco variables. IDs that
+ * are compact (the usual case) are indexed directly; otherwise the table
+ * falls back to a sorted list searched by bisection. If several particles
+ * share an ID, the first one encountered in the spill is kept.
+*/
+struct ParticleIndex
+{
+    /**
+     * Position of a reco particle within the spill.
+    */
+    struct Entry
+    {
+        uint32_t interaction;
+        uint32_t particle;
+    };
+
+    /**
+     * Marker for an ID that does not correspond to any reco particle.
+    */
+    static constexpr uint32_t kUnknown = UINT32_MAX;
+
+    std::vector<Entry> dense;
+    std::vector<std::pair<int64_t, Entry>> sparse;
+    bool built = false;
+    bool is_dense = false;
+
+    /**
+     * Invalidates the table for a new spill. The storage keeps its capacity.
+     * @return none.
+    */
+    void reset() { built = false; }
+
+    /**
+     * Builds the table from the reco particles of the spill.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return none.
+    */
+    void build(const caf::SRSpillProxy* sr)
+    {
+        size_t count(0);
+        int64_t lo(0), hi(-1);
+        for(auto const& i : sr->dlp)
+        {
+            for(auto const& p : i.particles)
+            {
+                int64_t id(p.id);
+                if(count == 0 || id < lo) lo = id;
+                if(count == 0 || id > hi) hi = id;
+                ++count;
+            }
+        }
+
+        is_dense = lo >= 0 && hi < int64_t(4 * count + 64);
+        dense.clear();
+        sparse.clear();
+        if(is_dense)
+            dense.assign(size_t(hi + 1), Entry{kUnknown, kUnknown});
+
+        for(uint32_t k(0); k < sr->dlp.size(); ++k)
+        {
+            auto const& i = sr->dlp[k];
+            for(uint32_t j(0); j < i.particles.size(); ++j)
+            {
+                int64_t id(i.particles[j].id);
+                if(!is_dense)
+                    sparse.emplace_back(id, Entry{k, j});
+                else if(dense[id].interaction == kUnknown)
+                    dense[id] = Entry{k, j};
+            }
+        }
+
+        if(!is_dense)
+        {
+            std::stable_sort(sparse.begin(), sparse.end(), [](const auto & a, const auto & b) { return a.first < b.first; });
+            sparse.erase(std::unique(sparse.begin(), sparse.end(), [](const auto & a, const auto & b) { return a.first == b.first; }), sparse.end());
+        }
+        built = true;
+    }
+
+    /**
+     * Finds the reco particle with the requested ID.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param id of the reco particle.
+     * @return a pointer to the reco particle, or nullptr if no reco particle
+     * in the spill has the requested ID.
+    */
+    const caf::SRParticleDLPProxy * find(const caf::SRSpillProxy* sr, int64_t id)
+    {
+        if(!built) build(sr);
+        Entry e{kUnknown, kUnknown};
+        if(is_dense)
+        {
+            if(id >= 0 && id < int64_t(dense.size()))
+                e = dense[id];
+        }
+        else
+        {
+            auto it = std::lower_bound(sparse.begin(), sparse.end(), id, [](const auto & a, int64_t v) { return a.first < v; });
+            if(it != sparse.end() && it->first == id)
+                e = it->second;
+        }
+        if(e.interaction == kUnknown) return nullptr;
+        return &sr->dlp[e.interaction].particles[e.particle];
+    }
+};
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file record_traits.h
+ * @brief Header file defining compile-time traits of the record types
+ * (proxies or snapshot views) that the cuts and variables are applied on.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef RECORD_TRAITS_H
+#define RECORD_TRAITS_H
+
+#include <type_traits>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+
+/**
+ * Trait identifying the true (as opposed to reco) interaction and particle
+ * types. The cuts and variables use it to select the truth attributes (e.g.
+ * truth_momentum instead of momentum), so that they apply equally to the
+ * SRProxy types and to the views of a SpillSnapshot (see snapshot.h).
+ * @tparam T the type of object (true or reco, interaction or particle).
+*/
+template<class T>
+struct is_truth : std::false_type {};
+
+template<>
+struct is_truth<caf::SRInteractionTruthDLPProxy> : std::true_type {};
+
+template<>
+struct is_truth<caf::SRParticleTruthDLPProxy> : std::true_type {};
+
+/**
+ * Shorthand for is_truth<T>::value.
+ * @tparam T the type of object (true or reco, interaction or particle).
+*/
+template<class T>
+constexpr bool is_truth_v = is_truth<T>::value;
+#endif
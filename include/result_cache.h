@@ -0,0 +1,385 @@
+/**
+ * @file result_cache.h
+ * @brief Header file defining a content-addressed cache of the per-file
+ * results (partial spectra, CSV logs, and row trees) of the selection.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TVectorD.h"
+
+#include "output_sink.h"
+#include "file_list.h"
+
+/**
+ * Cache of the results of the selection for each input file, enabled by
+ * setting SPEC_CACHE to the cache directory. An entry holds the unscaled
+ * spectra and POT of one input file (one object per spectrum, keyed by the
+ * name and binning of the spectrum) and the CSV logs and row trees written
+ * while processing it. Entries are addressed by a hash of
+ *
+ *   - the identity of the input file: its path, size, modification time,
+ *     and a checksum of its first and last 64 kB,
+ *   - the selection code: the headers in this directory, the macro being
+ *     compiled (__BASE_FILE__), and every file the macro includes (directly
+ *     or not) by a quoted #include relative to the including file (e.g.
+ *     montecarlo.C, included by montecarlo_batch.C). In a precompiled
+ *     selection library the hash of these files is computed at build time
+ *     and passed as SELECTION_SOURCE_HASH (see selection/CMakeLists.txt),
+ *     so that the key reflects the code compiled into the library rather
+ *     than the sources found at runtime,
+ *   - the build configuration of the selection (see configuration()),
+ *     which changes the results written without changing the sources.
+ *
+ * An input file is loaded from the cache only if its entry holds all the
+ * spectra requested; otherwise it is processed again and its entry is
+ * replaced. Entries are written to a temporary directory and renamed, so
+ * concurrent jobs may share a cache.
+*/
+class ResultCache
+{
+public:
+    /**
+     * Constructor for ResultCache. The cache is disabled if SPEC_CACHE is
+     * not set or if the selection code cannot be read.
+    */
+    ResultCache() : code(0)
+    {
+        const char * dir(std::getenv("SPEC_CACHE"));
+        if(dir == nullptr || *dir == '\0')
+            return;
+#ifdef SELECTION_SOURCE_HASH
+        code = hash(SELECTION_SOURCE_HASH, sizeof(SELECTION_SOURCE_HASH) - 1, kOffset);
+#else
+        std::vector<std::string> sources(glob_files(std::string(source_dir()) + "/*.h"));
+        add_source(__BASE_FILE__, sources);
+        code = kOffset;
+        for(const std::string & s : sources)
+        {
+            std::ifstream input(s, std::ios::binary);
+            if(!input.is_open())
+            {
+                std::cerr << "ResultCache: unable to read " << s << ", the cache is disabled." << std::endl;
+                return;
+            }
+            std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+            code = hash(content.data(), content.size(), hash(s.data(), s.size(), code));
+        }
+#endif
+        std::string config(configuration());
+        code = hash(config.data(), config.size(), code);
+        directory = dir;
+        mkdir(directory.c_str(), 0755);
+    }
+
+    /**
+     * Describes the preprocessor configuration the selection is compiled
+     * with: EVENTS_TREE (the row files hold an "events" tree),
+     * INSTRUMENTATION, and __AVX2__ (the batch kernels, see
+     * batch_kernels.h).
+     * @return the configuration, e.g. "EVENTS_TREE;AVX2;".
+    */
+    static std::string configuration()
+    {
+        std::string config;
+#ifdef EVENTS_TREE
+        config += "EVENTS_TREE;";
+#endif
+#ifdef INSTRUMENTATION
+        config += "INSTRUMENTATION;";
+#endif
+#ifdef __AVX2__
+        config += "AVX2;";
+#endif
+        return config;
+    }
+
+    /**
+     * Checks if the cache is enabled.
+     * @return true if the cache is enabled.
+    */
+    bool enabled() const { return !directory.empty(); }
+
+    /**
+     * Builds the key of a spectrum from its name, binning, and definition.
+     * @param name of the spectrum.
+     * @param edges the bin edges of each axis.
+     * @param definition of the spectrum when it is not fixed by the
+     * selection code (e.g. the variables and cut of a SpectrumManifest).
+     * @return the key of the spectrum.
+    */
+    static std::string spectrum_key(const std::string & name, const std::vector<std::vector<double>> & edges,
+                                    const std::string & definition="")
+    {
+        uint64_t h(hash(name.data(), name.size(), kOffset));
+        h = hash(definition.data(), definition.size(), h);
+        for(const std::vector<double> & e : edges)
+        {
+            uint64_t n(e.size());
+            h = hash(&n, sizeof(n), h);
+            h = hash(e.data(), e.size() * sizeof(double), h);
+        }
+        return hex(h);
+    }
+
+    /**
+     * Restores the results of an input file from the cache: the partial
+     * spectra file (one histogram per spectrum and the "exposure" vector)
+     * and the files of the registered outputs of the worker.
+     * @param file the input file.
+     * @param names the names of the spectra.
+     * @param keys the keys of the spectra (see spectrum_key()).
+     * @param partial the name of the partial spectra file to write.
+     * @param job the job index of the worker (see worker_job()).
+     * @return true if the results were restored.
+    */
+    bool load(const std::string & file, const std::vector<const char *> & names, const std::vector<std::string> & keys,
+              const std::string & partial, const std::string & job) const
+    {
+        std::string entry(entry_path(file));
+        if(entry.empty() || access((entry + "/complete").c_str(), R_OK) != 0)
+            return false;
+        TFile input((entry + "/spectra.root").c_str(), "READ");
+        std::vector<TH1 *> spectra;
+        TVectorD pot(keys.size());
+        bool found(true);
+        for(size_t i(0); i < keys.size() && found; ++i)
+        {
+            TH1 * h(input.Get<TH1>(("h_" + keys[i]).c_str()));
+            TVectorD * p(input.Get<TVectorD>(("p_" + keys[i]).c_str()));
+            found = h != nullptr && p != nullptr;
+            if(h != nullptr)
+            {
+                h->SetDirectory(nullptr);
+                spectra.push_back(h);
+            }
+            if(p != nullptr)
+            {
+                pot[i] = (*p)[0];
+                delete p;
+            }
+        }
+        input.Close();
+        if(found)
+        {
+            TFile output(partial.c_str(), "recreate");
+            for(size_t i(0); i < spectra.size(); ++i)
+                output.WriteObject(spectra[i], names[i]);
+            output.WriteObject(&pot, "exposure");
+            output.Close();
+            const std::vector<WorkerSink *> & sinks(WorkerSink::registry());
+            for(size_t j(0); j < sinks.size(); ++j)
+            {
+                for(size_t k(0); copy(entry + "/sink" + std::to_string(j) + "_" + std::to_string(k), sinks[j]->output(job, k)); ++k);
+            }
+        }
+        for(TH1 * h : spectra)
+            delete h;
+        return found;
+    }
+
+    /**
+     * Stores the results of a worker process in the cache, replacing the
+     * entry of the input file. The files of the worker are left in place.
+     * @param file the input file.
+     * @param names the names of the spectra.
+     * @param keys the keys of the spectra (see spectrum_key()).
+     * @param partial the name of the partial spectra file of the worker.
+     * @param job the job index of the worker (see worker_job()).
+     * @return none.
+    */
+    void store(const std::string & file, const std::vector<const char *> & names, const std::vector<std::string> & keys,
+               const std::string & partial, const std::string & job) const
+    {
+        std::string entry(entry_path(file));
+        if(entry.empty())
+            return;
+        std::string temporary(entry + ".tmp" + std::to_string(getpid()));
+        remove_entry(temporary);
+        if(mkdir(temporary.c_str(), 0755) != 0)
+            return;
+
+        TFile input(partial.c_str(), "READ");
+        TVectorD * pot(input.Get<TVectorD>("exposure"));
+        TFile output((temporary + "/spectra.root").c_str(), "recreate");
+        for(size_t i(0); i < keys.size(); ++i)
+        {
+            TH1 * h(input.Get<TH1>(names[i]));
+            TVectorD p(1);
+            p[0] = (*pot)[i];
+            output.WriteObject(h, ("h_" + keys[i]).c_str());
+            output.WriteObject(&p, ("p_" + keys[i]).c_str());
+            delete h;
+        }
+        output.Close();
+        delete pot;
+        input.Close();
+
+        const std::vector<WorkerSink *> & sinks(WorkerSink::registry());
+        for(size_t j(0); j < sinks.size(); ++j)
+        {
+            for(size_t k(0); copy(sinks[j]->output(job, k), temporary + "/sink" + std::to_string(j) + "_" + std::to_string(k)); ++k);
+        }
+        std::ofstream(temporary + "/complete").close();
+        remove_entry(entry);
+        if(std::rename(temporary.c_str(), entry.c_str()) != 0)
+            remove_entry(temporary);
+    }
+
+private:
+    /**
+     * FNV-1a hash of a block of data.
+     * @param data the data.
+     * @param size the size of the data in bytes.
+     * @param h the hash to continue from.
+     * @return the hash.
+    */
+    static uint64_t hash(const void * data, size_t size, uint64_t h)
+    {
+        const unsigned char * bytes(static_cast<const unsigned char *>(data));
+        for(size_t i(0); i < size; ++i)
+            h = (h ^ bytes[i]) * 1099511628211ULL;
+        return h;
+    }
+
+    /**
+     * Formats a hash as a hexadecimal string.
+     * @param h the hash.
+     * @return the hexadecimal string.
+    */
+    static std::string hex(uint64_t h)
+    {
+        char buffer[17];
+        std::snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)h);
+        return buffer;
+    }
+
+    /**
+     * Retrieves the directory of this header.
+     * @return the directory of this header.
+    */
+    static std::string source_dir()
+    {
+        std::string path(__FILE__);
+        size_t slash(path.find_last_of('/'));
+        return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+    }
+
+    /**
+     * Adds a source file of the selection and, recursively, the files it
+     * includes by a quoted #include that resolve relative to its directory
+     * (headers found only on the include path, e.g. those of sbnana, are
+     * not part of the selection code).
+     * @param file the source file.
+     * @param sources the source files, to which the files are added.
+     * @return none.
+    */
+    static void add_source(const std::string & file, std::vector<std::string> & sources)
+    {
+        for(const std::string & s : sources)
+            if(s == file) return;
+        sources.push_back(file);
+        size_t slash(file.find_last_of('/'));
+        std::string dir(slash == std::string::npos ? std::string() : file.substr(0, slash + 1));
+        std::ifstream input(file);
+        std::string line;
+        while(std::getline(input, line))
+        {
+            size_t c(line.find_first_not_of(" \t"));
+            if(c == std::string::npos || line[c] != '#')
+                continue;
+            c = line.find_first_not_of(" \t", c + 1);
+            if(c == std::string::npos || line.compare(c, 7, "include") != 0)
+                continue;
+            size_t open(line.find('"', c + 7));
+            size_t close(open == std::string::npos ? open : line.find('"', open + 1));
+            if(close == std::string::npos)
+                continue;
+            std::string included(line.substr(open + 1, close - open - 1));
+            if(included.empty() || included[0] != '/')
+                included = dir + included;
+            if(access(included.c_str(), R_OK) == 0)
+                add_source(included, sources);
+        }
+    }
+
+    /**
+     * Builds the path of the entry of an input file.
+     * @param file the input file.
+     * @return the path of the entry, or an empty string if the cache is
+     * disabled or the file cannot be read.
+    */
+    std::string entry_path(const std::string & file) const
+    {
+        struct stat status;
+        if(!enabled() || stat(file.c_str(), &status) != 0)
+            return std::string();
+        uint64_t h(hash(file.data(), file.size(), code));
+        int64_t identity[3] = {int64_t(status.st_size), int64_t(status.st_mtim.tv_sec), int64_t(status.st_mtim.tv_nsec)};
+        h = hash(identity, sizeof(identity), h);
+
+        std::ifstream input(file, std::ios::binary);
+        std::vector<char> block(kChecksumBytes);
+        input.read(block.data(), block.size());
+        h = hash(block.data(), input.gcount(), h);
+        if(status.st_size > int64_t(2 * kChecksumBytes))
+        {
+            input.clear();
+            input.seekg(-int64_t(kChecksumBytes), std::ios::end);
+            input.read(block.data(), block.size());
+            h = hash(block.data(), input.gcount(), h);
+        }
+        return directory + "/" + hex(h);
+    }
+
+    /**
+     * Copies a file.
+     * @param from the file to copy.
+     * @param to the name of the copy.
+     * @return true if the file was copied.
+    */
+    static bool copy(const std::string & from, const std::string & to)
+    {
+        if(from.empty() || to.empty())
+            return false;
+        std::ifstream input(from, std::ios::binary);
+        if(!input.is_open())
+            return false;
+        std::ofstream output(to, std::ios::binary | std::ios::trunc);
+        if(input.peek() != std::ifstream::traits_type::eof())
+            output << input.rdbuf();
+        return bool(output);
+    }
+
+    /**
+     * Removes an entry (a directory of plain files).
+     * @param entry the path of the entry.
+     * @return none.
+    */
+    static void remove_entry(const std::string & entry)
+    {
+        for(const std::string & f : glob_files(entry + "/*"))
+            std::remove(f.c_str());
+        rmdir(entry.c_str());
+    }
+
+    static constexpr uint64_t kOffset = 14695981039346656037ULL;
+    static constexpr size_t kChecksumBytes = 1 << 16;
+    std::string directory;
+    uint64_t code;
+};
+#endif
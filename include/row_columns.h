@@ -0,0 +1,80 @@
+/**
+ * @file row_columns.h
+ * @brief Header file defining the column registry of the rows (SIGNAL,
+ * SELECTED, selected_{channel}, DATA, events) written by the selection.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef ROW_COLUMNS_H
+#define ROW_COLUMNS_H
+
+#include <vector>
+
+/**
+ * The storage type of a column. Integer columns hold identifiers, flags, and
+ * categories; real columns hold everything else.
+*/
+enum class ColumnType { kInteger, kReal };
+
+/**
+ * A single column of a row schema.
+*/
+struct Column
+{
+    const char * name;
+    ColumnType type;
+};
+
+namespace rows
+{
+    /**
+     * Columns of the rows pairing a true and a reco interaction (SIGNAL,
+     * SELECTED, and selected_{channel} in the Monte Carlo). The order matches
+     * the order in which write_pair() streams the values.
+    */
+    const std::vector<Column> kPairColumns = {
+        {"run", ColumnType::kInteger}, {"event", ColumnType::kInteger}, {"subrun", ColumnType::kInteger},
+        {"nu_id", ColumnType::kInteger}, {"image_id", ColumnType::kInteger}, {"id", ColumnType::kInteger},
+        {"trigger", ColumnType::kReal},
+        {"category", ColumnType::kInteger}, {"category_topology", ColumnType::kInteger}, {"category_interaction_mode", ColumnType::kInteger},
+        {"true_muon_ke", ColumnType::kReal}, {"reco_muon_ke", ColumnType::kReal},
+        {"true_proton_ke", ColumnType::kReal}, {"reco_proton_ke", ColumnType::kReal},
+        {"true_visible_energy", ColumnType::kReal}, {"reco_visible_energy", ColumnType::kReal},
+        {"true_muon_pt", ColumnType::kReal}, {"reco_muon_pt", ColumnType::kReal},
+        {"true_proton_pt", ColumnType::kReal}, {"reco_proton_pt", ColumnType::kReal},
+        {"true_muon_polar_angle", ColumnType::kReal}, {"reco_muon_polar_angle", ColumnType::kReal},
+        {"true_muon_azimuthal_angle", ColumnType::kReal}, {"reco_muon_azimuthal_angle", ColumnType::kReal},
+        {"true_opening_angle", ColumnType::kReal}, {"reco_opening_angle", ColumnType::kReal},
+        {"true_delta_pT", ColumnType::kReal}, {"reco_delta_pT", ColumnType::kReal},
+        {"true_delta_phiT", ColumnType::kReal}, {"reco_delta_phiT", ColumnType::kReal},
+        {"true_delta_alphaT", ColumnType::kReal}, {"reco_delta_alphaT", ColumnType::kReal},
+        {"muon_softmax", ColumnType::kReal}, {"proton_softmax", ColumnType::kReal},
+        {"selected_1mu1p", ColumnType::kInteger}, {"selected_1muNp", ColumnType::kInteger}, {"selected_1muX", ColumnType::kInteger},
+        {"crtpmt_match", ColumnType::kInteger}, {"cryostat", ColumnType::kInteger}
+    };
+
+    /**
+     * Columns of the rows of selected reco interactions in data (DATA). The
+     * order matches the order in which write_reco() streams the values.
+    */
+    const std::vector<Column> kDataColumns = {
+        {"run", ColumnType::kInteger}, {"event", ColumnType::kInteger}, {"subrun", ColumnType::kInteger},
+        {"image_id", ColumnType::kInteger}, {"id", ColumnType::kInteger},
+        {"reco_muon_ke", ColumnType::kReal}, {"reco_proton_ke", ColumnType::kReal}, {"reco_visible_energy", ColumnType::kReal},
+        {"reco_muon_pt", ColumnType::kReal}, {"reco_proton_pt", ColumnType::kReal},
+        {"reco_muon_polar_angle", ColumnType::kReal}, {"reco_muon_azimuthal_angle", ColumnType::kReal},
+        {"reco_opening_angle", ColumnType::kReal}, {"reco_delta_pT", ColumnType::kReal},
+        {"reco_delta_phiT", ColumnType::kReal}, {"reco_delta_alphaT", ColumnType::kReal},
+        {"muon_softmax", ColumnType::kReal}, {"proton_softmax", ColumnType::kReal},
+        {"selected_1mu1p", ColumnType::kInteger}, {"selected_1muNp", ColumnType::kInteger}, {"selected_1muX", ColumnType::kInteger},
+        {"crtpmt_match", ColumnType::kInteger}, {"cryostat", ColumnType::kInteger}
+    };
+
+    /**
+     * Columns of the per-spill rows (events) listing every spill of the
+     * sample.
+    */
+    const std::vector<Column> kEventColumns = {
+        {"run", ColumnType::kInteger}, {"subrun", ColumnType::kInteger}, {"event", ColumnType::kInteger}
+    };
+}
+#endif
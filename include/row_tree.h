@@ -0,0 +1,208 @@
+/**
+ * @file row_tree.h
+ * @brief Header file defining typed columnar (TTree) output for the
+ * per-interaction rows written by the selection.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef ROW_TREE_H
+#define ROW_TREE_H
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "row_columns.h"
+#include "output_sink.h"
+
+/**
+ * A TTree with one branch per column of a schema (see row_columns.h). Integer
+ * columns are stored as Long64_t and real columns as Double_t. A row is
+ * written by streaming the values in column order and calling fill():
+ *
+ *     tree << run << event << ... ; tree.fill();
+ *
+ * Non-finite values in integer columns are stored as -9999.
+*/
+class RowTree
+{
+public:
+    /**
+     * Constructor for RowTree. The TTree is created in the current ROOT
+     * directory.
+     * @param name of the TTree.
+     * @param c the columns of the schema.
+    */
+    RowTree(const std::string & name, const std::vector<Column> & c)
+        : columns(c), integers(c.size(), 0), reals(c.size(), 0), next(0)
+    {
+        tree = new TTree(name.c_str(), name.c_str());
+        for(size_t k(0); k < columns.size(); ++k)
+        {
+            std::string leaf(std::string(columns[k].name) + (columns[k].type == ColumnType::kInteger ? "/L" : "/D"));
+            if(columns[k].type == ColumnType::kInteger)
+                tree->Branch(columns[k].name, &integers[k], leaf.c_str());
+            else
+                tree->Branch(columns[k].name, &reals[k], leaf.c_str());
+        }
+    }
+
+    /**
+     * Sets the value of the next column of the current row.
+     * @param value of the column.
+     * @return the RowTree (for chaining).
+    */
+    RowTree & operator<<(double value)
+    {
+        if(next < columns.size())
+        {
+            if(columns[next].type == ColumnType::kInteger)
+                integers[next] = std::isfinite(value) ? Long64_t(value) : -9999;
+            else
+                reals[next] = value;
+        }
+        ++next;
+        return *this;
+    }
+
+    /**
+     * Writes the current row to the TTree. Every column must have been set.
+     * @return none.
+    */
+    void fill()
+    {
+        if(next != columns.size())
+            throw std::runtime_error("RowTree " + std::string(tree->GetName()) + ": row has " + std::to_string(next)
+                                     + " values, expected " + std::to_string(columns.size()));
+        tree->Fill();
+        next = 0;
+    }
+
+    /**
+     * Writes a copy of the last row filled in another RowTree. Both trees
+     * must have the same schema.
+     * @param source the RowTree to copy the row from.
+     * @return none.
+    */
+    void fill(const RowTree & source)
+    {
+        std::copy(source.integers.begin(), source.integers.end(), integers.begin());
+        std::copy(source.reals.begin(), source.reals.end(), reals.begin());
+        next = columns.size();
+        fill();
+    }
+
+    TTree * tree;
+
+private:
+    std::vector<Column> columns;
+    std::vector<Long64_t> integers;
+    std::vector<Double_t> reals;
+    size_t next;
+};
+
+/**
+ * A ROOT file holding one RowTree per row tag (e.g. SIGNAL, SELECTED). The
+ * trees are written when the file is closed.
+*/
+class RowFile : public WorkerSink
+{
+public:
+    /**
+     * Constructor for RowFile.
+     * @param path of the output file (recreated if it exists). The job index
+     * is inserted if SELECTION_JOB is set, see sink_path().
+    */
+    RowFile(const std::string & path) : base(path), file(new TFile(sink_path(path).c_str(), "RECREATE")) {}
+
+    ~RowFile() override { close(); }
+
+    /**
+     * Adds a RowTree to the file.
+     * @param name of the TTree (the row tag).
+     * @param columns of the schema.
+     * @return the new RowTree.
+    */
+    RowTree & add(const std::string & name, const std::vector<Column> & columns)
+    {
+        file->cd();
+        trees.push_back(std::make_unique<RowTree>(name, columns));
+        return *trees.back();
+    }
+
+    /**
+     * Moves the (still empty) trees to a new file in a forked worker process,
+     * named according to the current SELECTION_JOB. The file inherited from
+     * the parent process is abandoned without being written.
+     * @return none.
+    */
+    void reopen() override
+    {
+        file = new TFile(sink_path(base).c_str(), "RECREATE");
+        for(const std::unique_ptr<RowTree> & t : trees)
+            t->tree->SetDirectory(file);
+    }
+
+    /**
+     * Writes the trees and closes the file. Further calls have no effect.
+     * @return none.
+    */
+    void close() override
+    {
+        if(!file)
+            return;
+        file->cd();
+        for(const std::unique_ptr<RowTree> & t : trees)
+            t->tree->Write();
+        file->Close();
+        delete file;
+        file = nullptr;
+    }
+
+    /**
+     * Appends the rows written by a worker process to the trees and removes
+     * the file of the worker.
+     * @param job the job index of the worker (see worker_job()).
+     * @return none.
+    */
+    void merge(const std::string & job) override
+    {
+        std::string path(output(job, 0));
+        TFile * input(new TFile(path.c_str(), "READ"));
+        if(input->IsZombie())
+            throw std::runtime_error("RowFile: unable to open " + path);
+        for(const std::unique_ptr<RowTree> & t : trees)
+        {
+            TTree * rows(input->Get<TTree>(t->tree->GetName()));
+            if(rows != nullptr)
+                t->tree->CopyEntries(rows);
+        }
+        input->Close();
+        delete input;
+        std::remove(path.c_str());
+    }
+
+    /**
+     * Builds the name of the file of a worker process.
+     * @param job the job index of the worker (see worker_job()).
+     * @param shard the index of the file (only 0 exists).
+     * @return the name of the file, or an empty string for shard > 0.
+    */
+    std::string output(const std::string & job, size_t shard) const override
+    {
+        return shard == 0 ? sink_path(base, 0, job) : std::string();
+    }
+
+private:
+    std::string base;
+    TFile * file;
+    std::vector<std::unique_ptr<RowTree>> trees;
+};
+#endif
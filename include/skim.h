@@ -0,0 +1,113 @@
+/**
+ * @file skim.h
+ * @brief Header file defining a spill-level skim of flat CAF files, used to
+ * produce reduced inputs for fast reruns of the selection.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SKIM_H
+#define SKIM_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TClass.h"
+
+#include "file_list.h"
+
+/**
+ * Writes a reduced flat CAF file holding only the spills of the input files
+ * that pass a spill-level predicate. Spills flagged as the first of their
+ * subrun are always kept, since they carry the POT and spill counts of the
+ * subrun in their header, so the POT accounting of the SpectrumLoader (and
+ * thus the scaling in SpecContainer) is unchanged by the skim. The
+ * histograms at the top level of the input files (e.g. TotalPOT and
+ * TotalEvents) are summed and written to the output file.
+ * @tparam F the type of the predicate.
+ * @param input the input flat CAF file(s) (a single file or a wildcard).
+ * @param output the name of the reduced flat CAF file.
+ * @param keep the predicate, called with the caf::SRSpillProxy of each
+ * spill; the spill is kept if it returns true.
+ * @return the number of spills kept.
+*/
+template<class F>
+    size_t skim_files(const std::string & input, const std::string & output, F keep)
+    {
+        std::vector<std::string> files(glob_files(input));
+        if(files.empty())
+            throw std::runtime_error("skim_files: no input files match " + input);
+
+        TFile * out(TFile::Open(output.c_str(), "RECREATE"));
+        TTree * skimmed(nullptr);
+        std::map<std::string, TH1 *> totals;
+        size_t total(0), kept(0);
+        for(const std::string & f : files)
+        {
+            TFile * in(TFile::Open(f.c_str(), "READ"));
+            if(in == nullptr || in->IsZombie())
+                throw std::runtime_error("skim_files: unable to open " + f);
+            TTree * tree(in->Get<TTree>("recTree"));
+            if(tree == nullptr)
+                throw std::runtime_error("skim_files: no recTree in " + f);
+
+            for(TObject * object : *in->GetListOfKeys())
+            {
+                TKey * key(static_cast<TKey *>(object));
+                TClass * type(TClass::GetClass(key->GetClassName()));
+                if(type == nullptr || !type->InheritsFrom(TH1::Class()))
+                    continue;
+                TH1 * h(static_cast<TH1 *>(key->ReadObj()));
+                if(totals.count(key->GetName()) == 0)
+                {
+                    h->SetDirectory(out);
+                    totals[key->GetName()] = h;
+                }
+                else
+                {
+                    totals[key->GetName()]->Add(h);
+                    delete h;
+                }
+            }
+
+            out->cd();
+            if(skimmed == nullptr)
+                skimmed = tree->CloneTree(0);
+            else
+                tree->CopyAddresses(skimmed);
+
+            long entry(0);
+            caf::SRSpillProxy sr(in, tree, "rec", entry, 0);
+            Long64_t entries(tree->GetEntries());
+            for(entry = 0; entry < entries; ++entry)
+            {
+                if(sr.hdr.first_in_subrun || keep(sr))
+                {
+                    tree->GetEntry(entry);
+                    skimmed->Fill();
+                    ++kept;
+                }
+            }
+            total += entries;
+            skimmed->AutoSave();
+            in->Close();
+            delete in;
+        }
+
+        out->cd();
+        skimmed->Write("", TObject::kOverwrite);
+        for(const std::pair<const std::string, TH1 *> & h : totals)
+            h.second->Write("", TObject::kOverwrite);
+        out->Close();
+        delete out;
+        std::cout << "skim_files: kept " << kept << " of " << total << " spills from " << files.size() << " files." << std::endl;
+        return kept;
+    }
+#endif
@@ -0,0 +1,331 @@
+/**
+ * @file snapshot.h
+ * @brief Header file defining a columnar (structure-of-arrays) snapshot of
+ * the reco and true interactions of a spill, along with lightweight views
+ * that the templates in cuts.h and variables.h can be applied on.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "record_traits.h"
+
+/**
+ * Flat copy of the selection attributes of the reco (or true) interactions of
+ * a spill. Each attribute is stored in its own contiguous column. The
+ * particles of interaction k occupy [particle_offsets[k],
+ * particle_offsets[k+1]) of the particle columns and its matches occupy
+ * [match_offsets[k], match_offsets[k+1]) of the match column. Three-vectors
+ * are stored as consecutive (x, y, z) triplets and the PID scores as
+ * consecutive groups of five. The truth-only particle columns are filled only
+ * for true interactions.
+*/
+struct SnapshotColumns
+{
+    static constexpr size_t kScores = 5;
+
+    std::vector<float> vertex;
+    std::vector<uint8_t> is_fiducial;
+    std::vector<uint8_t> is_contained;
+    std::vector<uint8_t> is_neutrino;
+    std::vector<float> flash_time;
+    std::vector<int32_t> fmatched;
+    std::vector<uint32_t> match_offsets;
+    std::vector<int64_t> match;
+    std::vector<uint32_t> particle_offsets;
+
+    std::vector<int32_t> pid;
+    std::vector<uint8_t> is_primary;
+    std::vector<float> csda_ke;
+    std::vector<float> calo_ke;
+    std::vector<float> momentum;
+    std::vector<float> start_dir;
+    std::vector<float> pid_scores;
+    std::vector<float> energy_deposit;
+    std::vector<float> energy_init;
+    std::vector<float> truth_momentum;
+    std::vector<float> truth_start_dir;
+
+    bool gathered = false;
+
+    /**
+     * Invalidates the columns for a new spill. The storage keeps its
+     * capacity.
+     * @return none.
+    */
+    void reset() { gathered = false; }
+
+    /**
+     * Copies the selection attributes of a set of interactions into the
+     * columns.
+     * @tparam V the type of the interaction vector (sr->dlp or sr->dlp_true).
+     * @param interactions the interactions to copy.
+     * @return none.
+    */
+    template<class V>
+        void gather(const V & interactions)
+        {
+            vertex.clear(); is_fiducial.clear(); is_contained.clear(); is_neutrino.clear();
+            flash_time.clear(); fmatched.clear(); match.clear();
+            match_offsets.assign(1, 0);
+            particle_offsets.assign(1, 0);
+            pid.clear(); is_primary.clear(); csda_ke.clear(); calo_ke.clear();
+            momentum.clear(); start_dir.clear(); pid_scores.clear();
+            energy_deposit.clear(); energy_init.clear(); truth_momentum.clear(); truth_start_dir.clear();
+            for(auto const& i : interactions)
+            {
+                for(size_t d(0); d < 3; ++d)
+                    vertex.push_back(i.vertex[d]);
+                is_fiducial.push_back(i.is_fiducial);
+                is_contained.push_back(i.is_contained);
+                is_neutrino.push_back(i.is_neutrino);
+                flash_time.push_back(i.flash_time);
+                fmatched.push_back(i.fmatched);
+                for(auto const& m : i.match)
+                    match.push_back(m);
+                match_offsets.push_back(match.size());
+
+                for(auto const& p : i.particles)
+                {
+                    pid.push_back(p.pid);
+                    is_primary.push_back(p.is_primary);
+                    csda_ke.push_back(p.csda_ke);
+                    calo_ke.push_back(p.calo_ke);
+                    for(size_t d(0); d < 3; ++d)
+                    {
+                        momentum.push_back(p.momentum[d]);
+                        start_dir.push_back(p.start_dir[d]);
+                    }
+                    for(size_t s(0); s < kScores; ++s)
+                        pid_scores.push_back(p.pid_scores[s]);
+                    if constexpr (is_truth_v<std::decay_t<decltype(p)>>)
+                    {
+                        energy_deposit.push_back(p.energy_deposit);
+                        energy_init.push_back(p.energy_init);
+                        for(size_t d(0); d < 3; ++d)
+                        {
+                            truth_momentum.push_back(p.truth_momentum[d]);
+                            truth_start_dir.push_back(p.truth_start_dir[d]);
+                        }
+                    }
+                }
+                particle_offsets.push_back(pid.size());
+            }
+            gathered = true;
+        }
+};
+
+/**
+ * Value of an attribute read from a SnapshotColumns. Like the SRProxy
+ * accessors, it converts implicitly to the underlying type, so expressions
+ * such as std::pow(p.momentum[0], 2) resolve to the same overloads (and
+ * evaluate with the same precision) on a view as on a proxy.
+ * @tparam T the type of the attribute.
+*/
+template<class T>
+struct ColumnValue
+{
+    T value;
+
+    operator T() const { return value; }
+};
+
+/**
+ * Read-only view of a fixed-size array attribute (e.g. a three-vector) within
+ * a SnapshotColumns.
+ * @tparam T the type of the elements.
+*/
+template<class T>
+struct ColumnArray
+{
+    const T * data;
+
+    ColumnValue<T> operator[](size_t i) const { return ColumnValue<T>{data[i]}; }
+};
+
+/**
+ * Read-only view of the matches of an interaction within a SnapshotColumns.
+*/
+struct MatchView
+{
+    const int64_t * data;
+    size_t count;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    int64_t operator[](size_t i) const { return data[i]; }
+    const int64_t * begin() const { return data; }
+    const int64_t * end() const { return data + count; }
+};
+
+/**
+ * View of a single particle within a SnapshotColumns. The attributes are
+ * named as in the SRProxy particle types, so the particle-level cuts and
+ * variables apply to it unchanged. The truth-only attributes are set only if
+ * Truth is true.
+ * @tparam Truth true for a true particle, false for a reco particle.
+*/
+template<bool Truth>
+struct ParticleView
+{
+    ColumnValue<int32_t> pid;
+    ColumnValue<bool> is_primary;
+    ColumnValue<float> csda_ke;
+    ColumnValue<float> calo_ke;
+    ColumnArray<float> momentum;
+    ColumnArray<float> start_dir;
+    ColumnArray<float> pid_scores;
+    ColumnValue<float> energy_deposit;
+    ColumnValue<float> energy_init;
+    ColumnArray<float> truth_momentum;
+    ColumnArray<float> truth_start_dir;
+
+    /**
+     * Creates the view of particle j of a SnapshotColumns.
+     * @param c the columns holding the particle.
+     * @param j the index of the particle within the particle columns.
+    */
+    ParticleView(const SnapshotColumns & c, size_t j)
+        : pid{c.pid[j]}, is_primary{bool(c.is_primary[j])}, csda_ke{c.csda_ke[j]}, calo_ke{c.calo_ke[j]},
+          momentum{&c.momentum[3 * j]}, start_dir{&c.start_dir[3 * j]}, pid_scores{&c.pid_scores[SnapshotColumns::kScores * j]},
+          energy_deposit{0}, energy_init{0}, truth_momentum{nullptr}, truth_start_dir{nullptr}
+    {
+        if constexpr (Truth)
+        {
+            energy_deposit.value = c.energy_deposit[j];
+            energy_init.value = c.energy_init[j];
+            truth_momentum.data = &c.truth_momentum[3 * j];
+            truth_start_dir.data = &c.truth_start_dir[3 * j];
+        }
+    }
+};
+
+template<>
+struct is_truth<ParticleView<true>> : std::true_type {};
+
+/**
+ * Read-only range of the particles of an interaction within a
+ * SnapshotColumns. Elements are returned as ParticleViews (by value).
+ * @tparam Truth true for true particles, false for reco particles.
+*/
+template<bool Truth>
+struct ParticleRange
+{
+    /**
+     * Forward iterator over the particles of the range.
+    */
+    struct iterator
+    {
+        const SnapshotColumns * columns;
+        size_t j;
+
+        ParticleView<Truth> operator*() const { return ParticleView<Truth>(*columns, j); }
+        iterator & operator++() { ++j; return *this; }
+        bool operator!=(const iterator & other) const { return j != other.j; }
+        bool operator==(const iterator & other) const { return j == other.j; }
+    };
+
+    const SnapshotColumns * columns;
+    size_t first;
+    size_t count;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    ParticleView<Truth> operator[](size_t i) const { return ParticleView<Truth>(*columns, first + i); }
+    iterator begin() const { return iterator{columns, first}; }
+    iterator end() const { return iterator{columns, first + count}; }
+};
+
+/**
+ * View of a single interaction within a SnapshotColumns. The attributes are
+ * named as in the SRProxy interaction types, so the interaction-level cuts in
+ * cuts.h (and the variables that only use the snapshot attributes) apply to
+ * it unchanged.
+ * @tparam Truth true for a true interaction, false for a reco interaction.
+*/
+template<bool Truth>
+struct InteractionView
+{
+    ColumnArray<float> vertex;
+    ColumnValue<bool> is_fiducial;
+    ColumnValue<bool> is_contained;
+    ColumnValue<bool> is_neutrino;
+    ColumnValue<float> flash_time;
+    ColumnValue<int32_t> fmatched;
+    MatchView match;
+    ParticleRange<Truth> particles;
+
+    /**
+     * Creates the view of interaction k of a SnapshotColumns.
+     * @param c the columns holding the interaction.
+     * @param k the index of the interaction.
+    */
+    InteractionView(const SnapshotColumns & c, size_t k)
+        : vertex{&c.vertex[3 * k]}, is_fiducial{bool(c.is_fiducial[k])}, is_contained{bool(c.is_contained[k])}, is_neutrino{bool(c.is_neutrino[k])},
+          flash_time{c.flash_time[k]}, fmatched{c.fmatched[k]},
+          match{c.match.data() + c.match_offsets[k], c.match_offsets[k + 1] - c.match_offsets[k]},
+          particles{&c, c.particle_offsets[k], c.particle_offsets[k + 1] - c.particle_offsets[k]} {}
+};
+
+template<>
+struct is_truth<InteractionView<true>> : std::true_type {};
+
+using RecoInteractionView = InteractionView<false>;
+using TrueInteractionView = InteractionView<true>;
+
+/**
+ * Columnar snapshot of the reco and true interactions of a spill. Each side
+ * is copied out of the proxies at most once per spill, on first use, after
+ * which the cuts and variables can run over the views without any proxy
+ * access.
+*/
+struct SpillSnapshot
+{
+    SnapshotColumns reco_columns;
+    SnapshotColumns true_columns;
+
+    /**
+     * Invalidates the snapshot for a new spill.
+     * @return none.
+    */
+    void reset()
+    {
+        reco_columns.reset();
+        true_columns.reset();
+    }
+
+    /**
+     * Retrieves the view of a reco interaction, copying the reco
+     * interactions of the spill on first use.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the interaction within sr->dlp.
+     * @return the view of the reco interaction.
+    */
+    RecoInteractionView reco(const caf::SRSpillProxy* sr, size_t k)
+    {
+        if(!reco_columns.gathered) reco_columns.gather(sr->dlp);
+        return RecoInteractionView(reco_columns, k);
+    }
+
+    /**
+     * Retrieves the view of a true interaction, copying the true
+     * interactions of the spill on first use.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the interaction within sr->dlp_true.
+     * @return the view of the true interaction.
+    */
+    TrueInteractionView truth(const caf::SRSpillProxy* sr, size_t k)
+    {
+        if(!true_columns.gathered) true_columns.gather(sr->dlp_true);
+        return TrueInteractionView(true_columns, k);
+    }
+};
+#endif
@@ -0,0 +1,466 @@
+/**
+ * @file spectrum_manifest.h
+ * @brief Header file defining a manifest of spectra (names, variables, cuts,
+ * and binnings) read from a TOML file at runtime.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SPECTRUM_MANIFEST_H
+#define SPECTRUM_MANIFEST_H
+
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <exception>
+#include <stdexcept>
+
+#include "sbnana/CAFAna/Core/MultiVar.h"
+#include "sbnana/CAFAna/Core/Binning.h"
+#include "sbnana/CAFAna/Core/Cut.h"
+
+#include "spill_plan.h"
+
+/**
+ * Manifest of spectra read from a TOML file, so that spectra can be added or
+ * rebinned without recompiling the macro. Each table of the file defines a
+ * spectrum named after the table:
+ *
+ *   [sVisibleEnergy_1mu1p]
+ *   type = '1d'
+ *   var = 'kVisibleEnergy_1mu1p'
+ *   bins = [25, 0, 3000]
+ *
+ *   [sFlowTTP_1mu1p]
+ *   type = '2d'
+ *   var = ['kCategoryTTP_NoCut', 'kFlowTTP_1mu1p']
+ *   bins = [[10, 0, 10], [5, 0, 5]]
+ *   cut = 'none'
+ *
+ * The variables are looked up by name among the SpillMultiVars defined
+ * through the macros in definitions.h (see SpillPlan::find()) and those
+ * added with add_var(). The interaction-level cuts are part of these
+ * variables; the optional spill cut is looked up among those added with
+ * add_cut() ("none" by default). A binning is given either by the number of
+ * bins and the range ("bins") or by the bin edges ("edges"). The spectra are
+ * added in the order of the file.
+*/
+class SpectrumManifest
+{
+public:
+    /**
+     * Constructor for SpectrumManifest. Reads and validates the manifest.
+     * @param path is the name of the TOML file.
+    */
+    SpectrumManifest(const std::string & path) : file(path)
+    {
+        std::ifstream input(path);
+        if(!input.is_open())
+            throw std::runtime_error("SpectrumManifest: unable to read " + path);
+        std::string line, pending;
+        size_t number(0), start(0);
+        while(std::getline(input, line))
+        {
+            ++number;
+            line = strip(line);
+            if(line.empty())
+                continue;
+            if(pending.empty())
+                start = number;
+            pending += line;
+            if(depth(pending) > 0)
+                continue;
+            parse_line(pending, start);
+            pending.clear();
+        }
+        if(!pending.empty())
+            throw std::runtime_error(location(start) + "unterminated array");
+        for(const Entry & e : entries)
+            check(e);
+    }
+
+    /**
+     * Adds the spectra of the manifest to a container.
+     * @tparam T the type of the container (SpecContainer or SpecBatch).
+     * @param spectra the container.
+     * @return none.
+    */
+    template<class T>
+        void add_spectra(T & spectra) const
+        {
+            for(const Entry & e : entries)
+            {
+                std::string definition(e.cut);
+                for(const std::string & v : e.vars)
+                    definition += "/" + v;
+                const char * name(strings().emplace(strings().end(), e.name)->c_str());
+                if(e.vars.size() == 1)
+                    spectra.add_spectrum1d(name, binning(e, 0), variable(e.vars[0]), cut(e.cut), definition);
+                else
+                    spectra.add_spectrum2d(name, binning(e, 0), binning(e, 1), variable(e.vars[0]),
+                                           variable(e.vars[1]), cut(e.cut), definition);
+            }
+        }
+
+    /**
+     * Number of spectra in the manifest.
+     * @return the number of spectra.
+    */
+    size_t size() const { return entries.size(); }
+
+    /**
+     * Makes a variable available to manifests in addition to the variables
+     * defined through the macros in definitions.h (e.g. kInfoVar).
+     * @param name of the variable in the manifest.
+     * @param var the variable.
+     * @return none.
+    */
+    static void add_var(const std::string & name, const ana::SpillMultiVar & var)
+    {
+        variables().erase(name);
+        variables().emplace(name, var);
+    }
+
+    /**
+     * Makes a spill cut available to manifests.
+     * @param name of the cut in the manifest.
+     * @param c the cut.
+     * @return none.
+    */
+    static void add_cut(const std::string & name, const ana::SpillCut & c)
+    {
+        cuts().erase(name);
+        cuts().emplace(name, c);
+    }
+
+private:
+    /**
+     * A value of the manifest: a string, a number, or an array.
+    */
+    struct Value
+    {
+        enum Kind { kString, kNumber, kArray } kind;
+        std::string string;
+        double number;
+        std::vector<Value> array;
+    };
+
+    /**
+     * The definition of a spectrum in the manifest.
+    */
+    struct Entry
+    {
+        std::string name;
+        size_t line;
+        std::string type;
+        std::vector<std::string> vars;
+        std::string cut;
+        std::vector<std::vector<double>> bins;
+        bool edges;
+    };
+
+    /**
+     * Removes the comment and the surrounding whitespace from a line.
+     * @param line of the manifest.
+     * @return the stripped line.
+    */
+    static std::string strip(const std::string & line)
+    {
+        char quote('\0');
+        size_t end(line.size());
+        for(size_t i(0); i < line.size(); ++i)
+        {
+            if(quote != '\0')
+                quote = line[i] == quote ? '\0' : quote;
+            else if(line[i] == '\'' || line[i] == '"')
+                quote = line[i];
+            else if(line[i] == '#')
+            {
+                end = i;
+                break;
+            }
+        }
+        size_t first(line.find_first_not_of(" \t\r"));
+        size_t last(line.find_last_not_of(" \t\r", end == 0 ? 0 : end - 1));
+        return first == std::string::npos || first >= end ? std::string() : line.substr(first, last - first + 1);
+    }
+
+    /**
+     * Nesting depth of the arrays still open at the end of a statement.
+     * @param text of the statement.
+     * @return the number of unclosed brackets.
+    */
+    static int depth(const std::string & text)
+    {
+        char quote('\0');
+        int d(0);
+        for(char c : text)
+        {
+            if(quote != '\0')
+                quote = c == quote ? '\0' : quote;
+            else if(c == '\'' || c == '"')
+                quote = c;
+            else if(c == '[')
+                ++d;
+            else if(c == ']')
+                --d;
+        }
+        return d;
+    }
+
+    /**
+     * Formats the location of an error in the manifest.
+     * @param line number of the statement.
+     * @return the location prefix of an error message.
+    */
+    std::string location(size_t line) const
+    {
+        return "SpectrumManifest: " + file + ":" + std::to_string(line) + ": ";
+    }
+
+    /**
+     * Parses a statement: a table header or a key/value pair.
+     * @param text of the statement.
+     * @param line number of the statement.
+     * @return none.
+    */
+    void parse_line(const std::string & text, size_t line)
+    {
+        if(text.front() == '[')
+        {
+            if(text.back() != ']' || text.compare(0, 2, "[[") == 0)
+                throw std::runtime_error(location(line) + "invalid table header " + text);
+            std::string name(strip(text.substr(1, text.size() - 2)));
+            if(name.size() > 1 && (name.front() == '\'' || name.front() == '"') && name.back() == name.front())
+                name = name.substr(1, name.size() - 2);
+            for(const Entry & e : entries)
+            {
+                if(e.name == name)
+                    throw std::runtime_error(location(line) + "duplicate spectrum " + name);
+            }
+            entries.push_back({name, line, "", {}, "none", {}, false});
+            return;
+        }
+        size_t equal(text.find('='));
+        if(equal == std::string::npos)
+            throw std::runtime_error(location(line) + "expected key = value");
+        if(entries.empty())
+            throw std::runtime_error(location(line) + "key outside of a spectrum table");
+        std::string key(strip(text.substr(0, equal)));
+        size_t position(0);
+        std::string rest(strip(text.substr(equal + 1)));
+        Value value(parse_value(rest, position, line));
+        if(strip(rest.substr(position)) != "")
+            throw std::runtime_error(location(line) + "unexpected text after the value of " + key);
+
+        Entry & e(entries.back());
+        if(key == "type" && value.kind == Value::kString)
+            e.type = value.string;
+        else if(key == "cut" && value.kind == Value::kString)
+            e.cut = value.string;
+        else if(key == "var" && value.kind == Value::kString)
+            e.vars = {value.string};
+        else if(key == "var" && value.kind == Value::kArray)
+        {
+            e.vars.clear();
+            for(const Value & v : value.array)
+            {
+                if(v.kind != Value::kString)
+                    throw std::runtime_error(location(line) + "var must be a string or an array of strings");
+                e.vars.push_back(v.string);
+            }
+        }
+        else if(key == "bins" || key == "edges")
+        {
+            e.edges = key == "edges";
+            e.bins.clear();
+            std::vector<const Value *> axes;
+            if(value.kind == Value::kArray && !value.array.empty() && value.array[0].kind == Value::kArray)
+                for(const Value & v : value.array) axes.push_back(&v);
+            else
+                axes.push_back(&value);
+            for(const Value * a : axes)
+            {
+                e.bins.emplace_back();
+                for(const Value & v : a->array)
+                {
+                    if(v.kind != Value::kNumber)
+                        throw std::runtime_error(location(line) + key + " must be an array of numbers (or of arrays of numbers)");
+                    e.bins.back().push_back(v.number);
+                }
+            }
+        }
+        else
+            throw std::runtime_error(location(line) + "unknown key or invalid value for " + key);
+    }
+
+    /**
+     * Parses a value (string, number, or array).
+     * @param text of the value.
+     * @param position in the text, advanced past the value.
+     * @param line number of the statement.
+     * @return the value.
+    */
+    Value parse_value(const std::string & text, size_t & position, size_t line) const
+    {
+        position = text.find_first_not_of(" \t", position);
+        if(position == std::string::npos)
+            throw std::runtime_error(location(line) + "missing value");
+        Value value;
+        char c(text[position]);
+        if(c == '\'' || c == '"')
+        {
+            size_t end(text.find(c, position + 1));
+            if(end == std::string::npos)
+                throw std::runtime_error(location(line) + "unterminated string");
+            value.kind = Value::kString;
+            value.string = text.substr(position + 1, end - position - 1);
+            position = end + 1;
+        }
+        else if(c == '[')
+        {
+            value.kind = Value::kArray;
+            ++position;
+            while(true)
+            {
+                position = text.find_first_not_of(" \t,", position);
+                if(position == std::string::npos)
+                    throw std::runtime_error(location(line) + "unterminated array");
+                if(text[position] == ']')
+                {
+                    ++position;
+                    break;
+                }
+                value.array.push_back(parse_value(text, position, line));
+            }
+        }
+        else
+        {
+            value.kind = Value::kNumber;
+            size_t used(0);
+            try
+            {
+                value.number = std::stod(text.substr(position), &used);
+            }
+            catch(const std::exception &)
+            {
+                throw std::runtime_error(location(line) + "invalid value " + text.substr(position));
+            }
+            position += used;
+        }
+        return value;
+    }
+
+    /**
+     * Validates the definition of a spectrum, including that its variables
+     * and cut exist.
+     * @param e the definition.
+     * @return none.
+    */
+    void check(const Entry & e) const
+    {
+        std::string where(location(e.line) + e.name + ": ");
+        size_t dimension(e.type == "1d" ? 1 : e.type == "2d" ? 2 : 0);
+        if(dimension == 0)
+            throw std::runtime_error(where + "type must be '1d' or '2d'");
+        if(e.vars.size() != dimension)
+            throw std::runtime_error(where + "expected " + std::to_string(dimension) + " variable(s)");
+        if(e.bins.size() != dimension)
+            throw std::runtime_error(where + "expected a binning for each of the " + std::to_string(dimension) + " axes");
+        for(const std::vector<double> & b : e.bins)
+        {
+            if(!e.edges && (b.size() != 3 || b[0] < 1 || b[0] != int(b[0]) || !(b[2] > b[1])))
+                throw std::runtime_error(where + "bins must be [number of bins, low edge, high edge]");
+            for(size_t i(1); e.edges && i < b.size(); ++i)
+            {
+                if(!(b[i] > b[i-1]))
+                    throw std::runtime_error(where + "edges must be increasing");
+            }
+            if(e.edges && b.size() < 2)
+                throw std::runtime_error(where + "edges must have at least two values");
+        }
+        for(const std::string & v : e.vars)
+            variable(v, where);
+        cut(e.cut, where);
+    }
+
+    /**
+     * Builds the binning of an axis of a spectrum.
+     * @param e the definition of the spectrum.
+     * @param i the index of the axis.
+     * @return the binning.
+    */
+    static ana::Binning binning(const Entry & e, size_t i)
+    {
+        const std::vector<double> & b(e.bins[i]);
+        return e.edges ? ana::Binning::Custom(b) : ana::Binning::Simple(int(b[0]), b[1], b[2]);
+    }
+
+    /**
+     * Looks up a variable by name.
+     * @param name of the variable.
+     * @param where prefix of the error message.
+     * @return the variable.
+    */
+    static ana::SpillMultiVar variable(const std::string & name, const std::string & where="SpectrumManifest: ")
+    {
+        SpillPlan::Binding binding(SpillPlan::instance().find(name));
+        if(binding)
+            return ana::SpillMultiVar(binding);
+        std::map<std::string, ana::SpillMultiVar>::const_iterator it(variables().find(name));
+        if(it == variables().end())
+            throw std::runtime_error(where + "unknown variable " + name);
+        return it->second;
+    }
+
+    /**
+     * Looks up a spill cut by name.
+     * @param name of the cut.
+     * @param where prefix of the error message.
+     * @return the cut.
+    */
+    static ana::SpillCut cut(const std::string & name, const std::string & where="SpectrumManifest: ")
+    {
+        if(name == "none")
+            return ana::kNoSpillCut;
+        std::map<std::string, ana::SpillCut>::const_iterator it(cuts().find(name));
+        if(it == cuts().end())
+            throw std::runtime_error(where + "unknown cut " + name);
+        return it->second;
+    }
+
+    /**
+     * The variables added with add_var().
+     * @return the map of the variables by name.
+    */
+    static std::map<std::string, ana::SpillMultiVar> & variables()
+    {
+        static std::map<std::string, ana::SpillMultiVar> v;
+        return v;
+    }
+
+    /**
+     * The spill cuts added with add_cut().
+     * @return the map of the cuts by name.
+    */
+    static std::map<std::string, ana::SpillCut> & cuts()
+    {
+        static std::map<std::string, ana::SpillCut> c;
+        return c;
+    }
+
+    /**
+     * Storage for the names of the spectra, which the containers keep as
+     * C strings for the lifetime of the process.
+     * @return the storage.
+    */
+    static std::deque<std::string> & strings()
+    {
+        static std::deque<std::string> s;
+        return s;
+    }
+
+    std::string file;
+    std::vector<Entry> entries;
+};
+#endif
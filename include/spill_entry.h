@@ -0,0 +1,63 @@
+/**
+ * @file spill_entry.h
+ * @brief Header file defining the identity of the spill currently handed to
+ * the cuts and variables by the loader.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SPILL_ENTRY_H
+#define SPILL_ENTRY_H
+
+#include <cstddef>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+
+/**
+ * Identity of a spill, used by the per-spill caches to detect the start of a
+ * new spill. The loader reuses the same SRSpillProxy for every spill, and the
+ * header (run, subrun, event) is not unique either (e.g. events duplicated in
+ * merged or skimmed inputs), so a spill is identified by the entry counter of
+ * the loader, which is advanced once per spill before any SpillMultiVar is
+ * evaluated on it (see ManifestLoader::HandleRecord()).
+*/
+struct SpillEntry
+{
+    const caf::SRSpillProxy * sr = nullptr;
+    size_t entry = 0;
+
+    /**
+     * The entry counter of the loader.
+     * @return the number of spills handed out by the loader so far.
+    */
+    static size_t & counter()
+    {
+        static size_t n(0);
+        return n;
+    }
+
+    /**
+     * Advances the entry counter of the loader to the next spill.
+     * @return none.
+    */
+    static void advance() { ++counter(); }
+
+    /**
+     * Checks whether a spill is the one recorded last.
+     * @param s is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return true if the spill has already been recorded.
+    */
+    bool same(const caf::SRSpillProxy* s) const { return s == sr && entry == counter(); }
+
+    /**
+     * Records the current spill.
+     * @param s is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return none.
+    */
+    void set(const caf::SRSpillProxy* s)
+    {
+        sr = s;
+        entry = counter();
+    }
+};
+#endif
@@ -0,0 +1,365 @@
+/**
+ * @file spill_plan.h
+ * @brief Header file defining a fused, single-pass evaluation plan for the
+ * SpillMultiVars created by the preprocessor macros in definitions.h.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SPILL_PLAN_H
+#define SPILL_PLAN_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "cut_cache.h"
+#include "summary_cache.h"
+#include "particle_index.h"
+#include "pair_table.h"
+#include "batch_kernels.h"
+#include "spill_entry.h"
+
+/**
+ * Fused evaluation plan for all SpillMultiVars defined through the macros in
+ * definitions.h. Each macro registers a "channel" with the plan: a callback
+ * that is broadcast over the reco/true interactions (or particles, or
+ * matched interaction pairs) of the spill and appends its results to a
+ * per-channel vector. The SpillMultiVar handed to the Spectrum only looks up
+ * the results of its channel. On the first lookup within a new spill, the
+ * plan walks sr->dlp and sr->dlp_true exactly once and evaluates every
+ * active channel along the way. A channel is activated the first time its
+ * SpillMultiVar is requested, so variables that are defined but never
+ * attached to a Spectrum cost nothing. The plan also owns the per-spill
+ * CutCache (with its SpillSnapshot), SummaryCache, ParticleIndex,
+ * ParticleBatch of the reco particles, and PairTable shared by all channels. Channels are also
+ * recorded under the name of their SpillMultiVar, so they can be found at
+ * runtime (see SpectrumManifest).
+*/
+struct SpillPlan
+{
+    using RecoFn = std::function<void(const caf::SRSpillProxy*, const caf::SRInteractionDLPProxy&, size_t, std::vector<double>&)>;
+    using TrueFn = std::function<void(const caf::SRSpillProxy*, const caf::SRInteractionTruthDLPProxy&, size_t, std::vector<double>&)>;
+    using RecoParticleFn = std::function<void(const caf::SRSpillProxy*, const caf::SRInteractionDLPProxy&, const caf::SRParticleDLPProxy&, std::vector<double>&)>;
+    using TrueParticleFn = std::function<void(const caf::SRSpillProxy*, const caf::SRInteractionTruthDLPProxy&, const caf::SRParticleTruthDLPProxy&, std::vector<double>&)>;
+    using PairFn = std::function<void(const caf::SRSpillProxy*, const PairTable::Pair&, size_t, std::vector<double>&)>;
+    using SpillFn = std::function<void(const caf::SRSpillProxy*, std::vector<double>&)>;
+    using Binding = std::function<std::vector<double>(const caf::SRSpillProxy*)>;
+
+    /**
+     * The level at which a channel is broadcast.
+    */
+    enum Level { kReco, kTrue, kRecoParticle, kTrueParticle, kPair, kSpill };
+
+    /**
+     * The set of channels (by position within the per-level callback lists)
+     * that a walk over the spill should evaluate.
+    */
+    struct Schedule
+    {
+        std::vector<size_t> reco;
+        std::vector<size_t> truth;
+        std::vector<size_t> reco_particle;
+        std::vector<size_t> true_particle;
+        std::vector<size_t> pair;
+        std::vector<size_t> spill;
+    };
+
+    std::vector<std::pair<Level, size_t>> channels;
+    std::vector<std::pair<size_t, RecoFn>> reco;
+    std::vector<std::pair<size_t, TrueFn>> truth;
+    std::vector<std::pair<size_t, RecoParticleFn>> reco_particle;
+    std::vector<std::pair<size_t, TrueParticleFn>> true_particle;
+    std::vector<std::pair<size_t, PairFn>> pair;
+    std::vector<std::pair<size_t, SpillFn>> spill;
+    std::map<std::string, Binding> named;
+    std::vector<bool> active;
+    std::vector<std::vector<double>> results;
+    Schedule schedule;
+    CutCache cache;
+    SummaryCache summaries;
+    ParticleIndex particle_index;
+    PairTable pair_table;
+    ParticleBatch reco_particles;
+
+    SpillEntry current;
+
+    /**
+     * Access the (single) plan shared by all macro-defined SpillMultiVars.
+     * @return the global SpillPlan.
+    */
+    static SpillPlan & instance()
+    {
+        static SpillPlan plan;
+        return plan;
+    }
+
+    /**
+     * Registers a channel broadcast over the reco interactions.
+     * @param fn the callback applied to each reco interaction.
+     * @param name of the SpillMultiVar, under which the channel can be
+     * found (see find()).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_reco(RecoFn fn, const char * name=nullptr)
+    {
+        reco.emplace_back(channels.size(), fn);
+        return add_channel(kReco, reco.size() - 1, name);
+    }
+
+    /**
+     * Registers a channel broadcast over the true interactions.
+     * @param fn the callback applied to each true interaction.
+     * @param name of the SpillMultiVar, under which the channel can be
+     * found (see find()).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_true(TrueFn fn, const char * name=nullptr)
+    {
+        truth.emplace_back(channels.size(), fn);
+        return add_channel(kTrue, truth.size() - 1, name);
+    }
+
+    /**
+     * Registers a channel broadcast over the particles of the reco
+     * interactions.
+     * @param fn the callback applied to each reco particle.
+     * @param name of the SpillMultiVar, under which the channel can be
+     * found (see find()).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_reco_particle(RecoParticleFn fn, const char * name=nullptr)
+    {
+        reco_particle.emplace_back(channels.size(), fn);
+        return add_channel(kRecoParticle, reco_particle.size() - 1, name);
+    }
+
+    /**
+     * Registers a channel broadcast over the particles of the true
+     * interactions.
+     * @param fn the callback applied to each true particle.
+     * @param name of the SpillMultiVar, under which the channel can be
+     * found (see find()).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_true_particle(TrueParticleFn fn, const char * name=nullptr)
+    {
+        true_particle.emplace_back(channels.size(), fn);
+        return add_channel(kTrueParticle, true_particle.size() - 1, name);
+    }
+
+    /**
+     * Registers a channel broadcast over the matched (truth->reco)
+     * interaction pairs of the PairTable.
+     * @param fn the callback applied to each matched pair.
+     * @param name of the SpillMultiVar, under which the channel can be
+     * found (see find()).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_pair(PairFn fn, const char * name=nullptr)
+    {
+        pair.emplace_back(channels.size(), fn);
+        return add_channel(kPair, pair.size() - 1, name);
+    }
+
+    /**
+     * Registers a channel that is evaluated once on the full spill.
+     * @param fn the callback applied to the spill.
+     * @param name of the SpillMultiVar, under which the channel can be
+     * found (see find()).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_spill(SpillFn fn, const char * name=nullptr)
+    {
+        spill.emplace_back(channels.size(), fn);
+        return add_channel(kSpill, spill.size() - 1, name);
+    }
+
+    /**
+     * Finds the lookup function of a channel by the name of its
+     * SpillMultiVar (e.g. "kVisibleEnergy_1mu1p").
+     * @param name of the SpillMultiVar.
+     * @return the function to wrap in a SpillMultiVar, or an empty function
+     * if there is no channel with this name.
+    */
+    Binding find(const std::string & name) const
+    {
+        std::map<std::string, Binding>::const_iterator it(named.find(name));
+        return it == named.end() ? Binding() : it->second;
+    }
+
+    /**
+     * Retrieves the results of a channel for the current spill. The fused
+     * walk over the spill is performed on the first request within a spill.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param id of the channel.
+     * @return the vector of results for the channel.
+    */
+    const std::vector<double> & evaluate(const caf::SRSpillProxy* sr, size_t id)
+    {
+        if(!same_spill(sr))
+        {
+            begin_spill(sr);
+            walk(sr, schedule);
+        }
+        if(!active[id])
+        {
+            Schedule single;
+            add_to(single, id);
+            add_to(schedule, id);
+            active[id] = true;
+            walk(sr, single);
+        }
+        return results[id];
+    }
+
+    /**
+     * Retrieves the structure-of-arrays buffer of the reco particles of the
+     * spill, gathering it on first use.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return the ParticleBatch of the reco particles.
+    */
+    ParticleBatch & reco_batch(const caf::SRSpillProxy* sr)
+    {
+        if(!reco_particles.gathered) reco_particles.gather(sr->dlp);
+        return reco_particles;
+    }
+
+    /**
+     * Checks whether the spill is the one the current results belong to. The
+     * proxy object is reused by the loader, so the spill is identified by the
+     * entry counter of the loader (see SpillEntry).
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return true if the spill has already been walked.
+    */
+    bool same_spill(const caf::SRSpillProxy* sr) const
+    {
+        return current.same(sr);
+    }
+
+    /**
+     * Resets the per-spill state of the plan. The result vectors are cleared
+     * but keep their capacity, so steady-state running does not allocate.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return none.
+    */
+    void begin_spill(const caf::SRSpillProxy* sr)
+    {
+        current.set(sr);
+        cache.reset(sr);
+        summaries.reset(sr);
+        particle_index.reset();
+        pair_table.reset();
+        reco_particles.reset();
+        for(std::vector<double> & r : results)
+            r.clear();
+    }
+
+    /**
+     * Walks the spill once, evaluating each scheduled channel.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param s the schedule of channels to evaluate.
+     * @return none.
+    */
+    void walk(const caf::SRSpillProxy* sr, const Schedule & s)
+    {
+        if(!s.reco.empty() || !s.reco_particle.empty())
+        {
+            for(size_t k(0); k < sr->dlp.size(); ++k)
+            {
+                auto const& i = sr->dlp[k];
+                for(size_t c : s.reco)
+                    reco[c].second(sr, i, k, results[reco[c].first]);
+                if(s.reco_particle.empty()) continue;
+                for(auto const& p : i.particles)
+                {
+                    for(size_t c : s.reco_particle)
+                        reco_particle[c].second(sr, i, p, results[reco_particle[c].first]);
+                }
+            }
+        }
+        if(!s.truth.empty() || !s.true_particle.empty())
+        {
+            for(size_t k(0); k < sr->dlp_true.size(); ++k)
+            {
+                auto const& i = sr->dlp_true[k];
+                for(size_t c : s.truth)
+                    truth[c].second(sr, i, k, results[truth[c].first]);
+                if(s.true_particle.empty()) continue;
+                for(auto const& p : i.particles)
+                {
+                    for(size_t c : s.true_particle)
+                        true_particle[c].second(sr, i, p, results[true_particle[c].first]);
+                }
+            }
+        }
+        if(!s.pair.empty())
+        {
+            const std::vector<PairTable::Pair> & pairs(pair_table.build(sr, cache));
+            for(size_t p(0); p < pairs.size(); ++p)
+            {
+                for(size_t c : s.pair)
+                    pair[c].second(sr, pairs[p], p, results[pair[c].first]);
+            }
+        }
+        for(size_t c : s.spill)
+            spill[c].second(sr, results[spill[c].first]);
+    }
+
+    /**
+     * Adds a channel to a schedule.
+     * @param s the schedule to modify.
+     * @param id of the channel.
+     * @return none.
+    */
+    void add_to(Schedule & s, size_t id) const
+    {
+        const std::pair<Level, size_t> & c = channels[id];
+        switch(c.first)
+        {
+        case kReco:
+            s.reco.push_back(c.second);
+            break;
+        case kTrue:
+            s.truth.push_back(c.second);
+            break;
+        case kRecoParticle:
+            s.reco_particle.push_back(c.second);
+            break;
+        case kTrueParticle:
+            s.true_particle.push_back(c.second);
+            break;
+        case kPair:
+            s.pair.push_back(c.second);
+            break;
+        case kSpill:
+            s.spill.push_back(c.second);
+            break;
+        }
+    }
+
+    /**
+     * Records a new channel and creates the lookup function for it.
+     * @param level at which the channel is broadcast.
+     * @param index of the callback within the per-level list.
+     * @param name of the SpillMultiVar (optional).
+     * @return the function to wrap in a SpillMultiVar.
+    */
+    Binding add_channel(Level level, size_t index, const char * name)
+    {
+        size_t id(channels.size());
+        channels.emplace_back(level, index);
+        active.push_back(false);
+        results.emplace_back();
+        Binding binding([id](const caf::SRSpillProxy* sr) { return SpillPlan::instance().evaluate(sr, id); });
+        if(name != nullptr)
+            named[name] = binding;
+        return binding;
+    }
+};
+#endif
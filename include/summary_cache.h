@@ -0,0 +1,117 @@
+/**
+ * @file summary_cache.h
+ * @brief Header file defining a per-spill cache of the kinematic summaries
+ * of the interactions.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SUMMARY_CACHE_H
+#define SUMMARY_CACHE_H
+
+#include <vector>
+#include <type_traits>
+
+#include "sbnanaobj/StandardRecord/Proxy/SRProxy.h"
+#include "numu_variables.h"
+
+/**
+ * Per-spill cache of the KinematicSummary (see vars::summarize()) of each
+ * reco and true interaction, keyed by the index of the interaction within
+ * sr->dlp or sr->dlp_true. The summary of an interaction is computed on
+ * first use and shared by every numu variable evaluated on it in the same
+ * spill (see SUMMARY_VAR).
+*/
+struct SummaryCache
+{
+    std::vector<vars::KinematicSummary> reco;
+    std::vector<vars::KinematicSummary> truth;
+    std::vector<bool> reco_filled;
+    std::vector<bool> true_filled;
+
+    /**
+     * Invalidates all entries of the cache and sizes it for a new spill.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @return none.
+    */
+    void reset(const caf::SRSpillProxy* sr)
+    {
+        reco.resize(sr->dlp.size());
+        truth.resize(sr->dlp_true.size());
+        reco_filled.assign(sr->dlp.size(), false);
+        true_filled.assign(sr->dlp_true.size(), false);
+    }
+
+    /**
+     * Retrieves the kinematic summary of a reco interaction.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the reco interaction.
+     * @return the kinematic summary of the interaction.
+    */
+    const vars::KinematicSummary & reco_summary(const caf::SRSpillProxy* sr, size_t k)
+    {
+        if(!reco_filled[k])
+        {
+            reco[k] = vars::summarize(sr->dlp[k]);
+            reco_filled[k] = true;
+        }
+        return reco[k];
+    }
+
+    /**
+     * Retrieves the kinematic summary of a true interaction.
+     * @param sr is an SRSpillProxy that attaches to the StandardRecord of the
+     * current spill.
+     * @param k the index of the true interaction.
+     * @return the kinematic summary of the interaction.
+    */
+    const vars::KinematicSummary & true_summary(const caf::SRSpillProxy* sr, size_t k)
+    {
+        if(!true_filled[k])
+        {
+            truth[k] = vars::summarize(sr->dlp_true[k]);
+            true_filled[k] = true;
+        }
+        return truth[k];
+    }
+};
+
+/**
+ * Evaluates a variable on an interaction, through its accessor taking the
+ * KinematicSummary if it has one (see numu_variables.h).
+ * @tparam G the accessor form of the variable (interaction, summary).
+ * @tparam F the single-argument form of the variable.
+ * @tparam T the type of interaction (true or reco).
+ * @tparam S the type of the function retrieving the summary.
+ * @param accessor the accessor form of the variable.
+ * @param single the single-argument form of the variable.
+ * @param interaction to apply the variable on.
+ * @param summary retrieves the summary of the interaction (called only if
+ * the variable has an accessor form).
+ * @return the value of the variable.
+*/
+template<class G, class F, class T, class S>
+    double summarized(const G & accessor, const F & single, const T & interaction, const S & summary)
+    {
+        if constexpr (std::is_invocable_v<const G &, const T &, const vars::KinematicSummary &>)
+            return accessor(interaction, summary());
+        else
+            return single(interaction);
+    }
+
+/**
+ * Preprocessor wrapper evaluating a variable on an interaction with the
+ * cached KinematicSummary of the interaction, if the variable has a form
+ * taking the summary, and with the single-argument form otherwise.
+ * @param VAR the variable.
+ * @param INTERACTION to apply the variable on.
+ * @param SUMMARY expression retrieving the summary of the interaction from
+ * the SummaryCache (evaluated only if needed).
+ * @return the value of the variable.
+*/
+#define SUMMARY_VAR(VAR,INTERACTION,SUMMARY)                                                     \
+    summarized([](const auto & i_, const auto & s_) -> decltype(VAR(i_, s_)) { return VAR(i_, s_); }, \
+               [](const auto & i_) -> double { return VAR(i_); },                                \
+               INTERACTION,                                                                       \
+               [&]() -> const vars::KinematicSummary & { return SUMMARY; })
+#endif
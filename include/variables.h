@@ -13,6 +13,8 @@
 
 #include <algorithm>
 
+#include "record_traits.h"
+
 namespace vars
 {
 
@@ -66,54 +68,59 @@ namespace vars
      * 7: cosmic
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param code the topology code of the interaction (see
+     * cuts::count_primaries()).
      * @return the enumerated category of the interaction.
     */
     template<class T>
-        double category(const T & interaction)
+        double category(const T & interaction, cuts::topology_t code)
         {
             double cat(7);
-            if(cuts::signal_1mu1p(interaction))
-            {
-                if(cuts::fiducial_containment_cut(interaction)) cat = 0;
-                else cat = 1;
-            }
-            else if(cuts::signal_1muNp(interaction))
-            {
-                if(cuts::fiducial_containment_cut(interaction)) cat = 2;
-                else cat = 3;
-            }
-            else if(cuts::signal_1muX(interaction))
+            if(cuts::neutrino(interaction))
             {
-                if(cuts::fiducial_containment_cut(interaction)) cat = 4;
-                else cat = 5;
+                bool fv(cuts::fiducial_containment_cut(interaction));
+                if(cuts::is_1mu1p(code)) cat = fv ? 0 : 1;
+                else if(cuts::is_1muNp(code)) cat = fv ? 2 : 3;
+                else if(cuts::is_1muX(code)) cat = fv ? 4 : 5;
+                else cat = 6;
             }
-            else if(cuts::other_nu_1muX(interaction)) cat = 6;
             return cat;
         }
 
+    /**
+     * Variable for enumerating interaction categories (see above).
+     * @tparam T the type of interaction (true or reco).
+     * @param interaction to apply the variable on.
+     * @return the enumerated category of the interaction.
+    */
+    template<class T>
+        double category(const T & interaction) { return category(interaction, cuts::count_primaries(interaction)); }
+
     /**
      * Variable for enumerating interaction categories. This classifies the
      * interactions based on the visible final states.
      * 0: 1mu1p, 1: 1mu0h, 2: 1muNp (N>1), 3: 1mu1p1pi, 4: nu_mu CC Other, 5: NC, 6: Cosmic
      * @tparam T the type of interaction (true or reco).
      * @param interaction to apply the variable on.
+     * @param code the topology code of the interaction (see
+     * cuts::count_primaries()).
      * @return the enumerated category of the interaction.
     */
     template<class T>
-        double category_topology(const T & interaction)
+        double category_topology(const T & interaction, cuts::topology_t code)
         {
             uint16_t cat(6);
             if(interaction.is_neutrino)
             {
-                std::vector<uint32_t> counts(cuts::count_primaries(interaction));
-                if(counts[0] == 0 && counts[1] == 0 && counts[2] == 1)
+                uint32_t npi(cuts::topology_count(code, 3)), np(cuts::topology_count(code, 4));
+                if(cuts::topology_count(code, 0) == 0 && cuts::topology_count(code, 1) == 0 && cuts::topology_count(code, 2) == 1)
                 {
-                    if(counts[3] == 0 && counts[4] == 1 && interaction.is_contained && interaction.is_fiducial) cat = 0;
-                    else if(counts[3] == 0 && counts[4] == 1) cat = 7;
-                    else if(counts[3] == 0 && counts[4] == 0) cat = 1;
-                    else if(counts[3] == 0 && counts[4] > 1 && interaction.is_contained && interaction.is_fiducial) cat = 2;
-                    else if(counts[3] == 0 && counts[4] > 1) cat = 7;
-                    else if(counts[3] == 1 && counts[4] == 1) cat = 3;
+                    if(npi == 0 && np == 1 && interaction.is_contained && interaction.is_fiducial) cat = 0;
+                    else if(npi == 0 && np == 1) cat = 7;
+                    else if(npi == 0 && np == 0) cat = 1;
+                    else if(npi == 0 && np > 1 && interaction.is_contained && interaction.is_fiducial) cat = 2;
+                    else if(npi == 0 && np > 1) cat = 7;
+                    else if(npi == 1 && np == 1) cat = 3;
                     else if(interaction.nu_current_type == 0) cat = 4;
                 }
                 else if(interaction.nu_current_type == 0) cat = 4;
@@ -122,6 +129,16 @@ namespace vars
             return cat;
         }
 
+    /**
+     * Variable for enumerating interaction categories based on the visible
+     * final states (see above).
+     * @tparam T the type of interaction (true or reco).
+     * @param interaction to apply the variable on.
+     * @return the enumerated category of the interaction.
+    */
+    template<class T>
+        double category_topology(const T & interaction) { return category_topology(interaction, cuts::count_primaries(interaction)); }
+
     /**
      * Variable for enumerating interaction categories. This categorization
      * uses the interaction type (generator truth) classify the interactions
@@ -308,7 +325,7 @@ namespace vars
             {
                 const auto & p = interaction.particles[i];
                 double energy(csda_ke(p));
-                if constexpr (std::is_same_v<T, caf::SRInteractionTruthDLPProxy>)
+                if constexpr (is_truth_v<T>)
                     energy = ke_init(p);
                 if(p.pid == pid && energy > leading_ke)
                 {
@@ -392,8 +409,8 @@ namespace vars
     template<class T>
         double cosine_opening_angle(const T & interaction)
         {
-            auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
-            auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
+            const auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
+            const auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
             double num(m.start_dir[0] * p.start_dir[0] + m.start_dir[1] * p.start_dir[1] + m.start_dir[2] * p.start_dir[2]);
             return num;
         }
@@ -409,8 +426,8 @@ namespace vars
     template<class T>
         double cosine_opening_angle_transverse(const T & interaction)
         {
-            auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
-            auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
+            const auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
+            const auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
             double num(m.start_dir[0] * p.start_dir[0] + m.start_dir[1] * p.start_dir[1]);
             num /= std::sqrt((1-m.start_dir[2]*m.start_dir[2])*(1-p.start_dir[2]*p.start_dir[2]));
             return num;
@@ -425,7 +442,7 @@ namespace vars
     template<class T>
         double leading_muon_softmax(const T & interaction)
         {
-            auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
+            const auto & m(interaction.particles[leading_particle_index(interaction, 2)]);
             return m.pid_scores[2];
         }
     
@@ -438,7 +455,7 @@ namespace vars
     template<class T>
         double leading_proton_softmax(const T & interaction)
         {
-            auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
+            const auto & p(interaction.particles[leading_particle_index(interaction, 4)]);
             return p.pid_scores[4];
         }
 
@@ -458,7 +475,7 @@ namespace vars
             size_t i(leading_particle_index(interaction, 4));
             if(interaction.particles.size() <= i)
                 return cos;
-            auto & p(interaction.particles[i]);
+            const auto & p(interaction.particles[i]);
             if(p.pid == 4 && p.is_primary)
             {
                 /**
@@ -0,0 +1,135 @@
+/**
+ * @file worker_pool.h
+ * @brief Header file defining a pool of forked worker processes, used to
+ * process several samples or input files concurrently.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+#include <functional>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "output_sink.h"
+
+/**
+ * Retrieves the number of worker processes requested for the run from
+ * SPEC_WORKERS, so that a macro does not use more cores than its batch slot
+ * (or the user) provides.
+ * @return the number of workers (default: 1).
+*/
+inline size_t worker_count()
+{
+    const char * workers(std::getenv("SPEC_WORKERS"));
+    if(workers == nullptr || *workers == '\0')
+        return 1;
+    return std::max<size_t>(std::strtoul(workers, nullptr, 10), 1);
+}
+
+/**
+ * Runs a set of tasks in forked worker processes, with at most a given
+ * number of workers running at a time. Processes are used rather than
+ * threads because the CAFAna loaders and the outputs of the selection are
+ * not safe to share between threads. Each worker sets SELECTION_JOB to
+ * worker_job(k), where k is the index of its task, and reopens all
+ * registered outputs (see WorkerSink), so the CSV logs and row trees of task
+ * k are written to files of their own; they can be collected afterwards with
+ * merge_worker_outputs(). Nothing must be written to the registered outputs
+ * before the call.
+ * @param tasks the indices of the tasks to run.
+ * @param workers the maximum number of concurrent workers.
+ * @param task the body of a task, called with the index of the task in the
+ * worker process.
+ * @param done called in the current process with the index of each task
+ * and its success, in order of completion (optional).
+ * @return the success of each task (in the order of tasks).
+*/
+inline std::vector<bool> run_workers(const std::vector<size_t> & tasks, size_t workers,
+                                     const std::function<void(size_t)> & task,
+                                     const std::function<void(size_t, bool)> & done=nullptr)
+{
+    workers = std::max<size_t>(workers, 1);
+    std::cout.flush();
+    std::cerr.flush();
+    std::vector<pid_t> pids(tasks.size(), -1);
+    std::vector<bool> success(tasks.size(), false);
+    size_t next(0), running(0);
+    while(next < tasks.size() || running > 0)
+    {
+        if(next < tasks.size() && running < workers)
+        {
+            pid_t pid(fork());
+            if(pid == 0)
+            {
+                int status(0);
+                try
+                {
+                    setenv("SELECTION_JOB", worker_job(tasks[next]).c_str(), 1);
+                    for(WorkerSink * s : WorkerSink::registry())
+                        s->reopen();
+                    task(tasks[next]);
+                    for(WorkerSink * s : WorkerSink::registry())
+                        s->close();
+                }
+                catch(const std::exception & e)
+                {
+                    std::cerr << "Worker " << tasks[next] << " failed: " << e.what() << std::endl;
+                    status = 1;
+                }
+                std::cout.flush();
+                std::cerr.flush();
+                _exit(status);
+            }
+            if(pid < 0)
+            {
+                std::cerr << "Unable to start worker " << tasks[next] << std::endl;
+                if(done)
+                    done(tasks[next], false);
+            }
+            else
+            {
+                pids[next] = pid;
+                ++running;
+            }
+            ++next;
+            continue;
+        }
+
+        int status;
+        pid_t pid(wait(&status));
+        if(pid < 0)
+            break;
+        --running;
+        size_t t(std::find(pids.begin(), pids.end(), pid) - pids.begin());
+        if(t < tasks.size())
+        {
+            success[t] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if(done)
+                done(tasks[t], success[t]);
+        }
+    }
+    return success;
+}
+
+/**
+ * Appends the CSV logs and row trees written by a worker process to the
+ * outputs of the current process and removes the files of the worker.
+ * Calling this for the workers in task order gives the same rows, in the
+ * same order, as running the tasks sequentially in the current process.
+ * @param k the index of the task of the worker.
+ * @return none.
+*/
+inline void merge_worker_outputs(size_t k)
+{
+    for(WorkerSink * s : WorkerSink::registry())
+        s->merge(worker_job(k));
+}
+#endif
@@ -68,7 +68,11 @@ def plot_flow(rf, desc):
     npops = len(desc.pops)
     bar_size = 1.0 / (npops+1)
     ylocs = np.arange(len(desc.cuts)) * (bar_size * (npops + 1))
-    counts = np.array([load_histograms(rf, f'sCount{desc.direction.upper()}_{c}')[0] for c in desc.cuts])[::-1,:,0]
+    if hasattr(desc, 'flow'):
+        flow = load_histograms(rf, f'sFlow{desc.direction.upper()}_{desc.flow}')[0]
+        counts = np.array([np.sum(flow[:,ci:], axis=1) for ci in range(len(desc.cuts))])[::-1,:]
+    else:
+        counts = np.array([load_histograms(rf, f'sCount{desc.direction.upper()}_{c}')[0] for c in desc.cuts])[::-1,:,0]
     for pi, pop in enumerate(desc.pops):
         total = np.sum(counts[:,pop], axis=1) if isinstance(pop, list) else counts[:,pop]
         ax.barh(ylocs + (pi + npops * -0.5)*bar_size, total, align='edge', height=bar_size, label=desc.labels[pi])
@@ -0,0 +1,25 @@
+/**
+ * @file driver.cc
+ * @brief Driver executable of a precompiled selection library. Runs the main
+ * function of the macro compiled into the library it is linked against.
+ * @author justin.mueller@colostate.edu
+*/
+
+#include <iostream>
+#include <exception>
+
+extern "C" void selection_main();
+
+int main()
+{
+    try
+    {
+        selection_main();
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr << "Selection failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file entry.h
+ * @brief Header file defining the entry point of a precompiled selection
+ * library. It is included ahead of the macro (e.g. analysis.C) when the
+ * macro is compiled into a shared library (see CMakeLists.txt), with
+ * SELECTION_ENTRY set to the name of the main function of the macro.
+ * @author justin.mueller@colostate.edu
+*/
+#ifndef SELECTION_ENTRY_H
+#define SELECTION_ENTRY_H
+
+#ifndef SELECTION_ENTRY
+#error "SELECTION_ENTRY must be set to the main function of the macro."
+#endif
+
+void SELECTION_ENTRY();
+
+/**
+ * Runs the main function of the macro compiled into the library. The name
+ * is the same for every library so that a single driver can call it.
+ * @return none.
+*/
+extern "C" void selection_main() { SELECTION_ENTRY(); }
+#endif
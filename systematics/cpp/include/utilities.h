@@ -37,9 +37,9 @@ void read_event_metadata(std::vector<meta_t> & events, const std::string & file_
      * for the event metadata.
     */
     TTreeReader reader("events", file);
-    TTreeReaderValue<double> run(reader, "run");
-    TTreeReaderValue<double> subrun(reader, "subrun");
-    TTreeReaderValue<double> event(reader, "event");
+    TTreeReaderValue<Long64_t> run(reader, "run");
+    TTreeReaderValue<Long64_t> subrun(reader, "subrun");
+    TTreeReaderValue<Long64_t> event(reader, "event");
 
     /**
      * Loop over the events and store the event metadata.
@@ -78,10 +78,10 @@ void read_selected(std::map<index_t, std::vector<double>> & reco_map, const std:
      * in vars.h).
     */
     TTreeReader reader("selected_1mu1p", file);
-    TTreeReaderValue<double> run(reader, "run");
-    TTreeReaderValue<double> subrun(reader, "subrun");
-    TTreeReaderValue<double> event(reader, "event");
-    TTreeReaderValue<double> nu_id(reader, "nu_id");
+    TTreeReaderValue<Long64_t> run(reader, "run");
+    TTreeReaderValue<Long64_t> subrun(reader, "subrun");
+    TTreeReaderValue<Long64_t> event(reader, "event");
+    TTreeReaderValue<Long64_t> nu_id(reader, "nu_id");
     std::vector<TTreeReaderValue<double>> vars;
     for(size_t ri(0); ri < reco_vars.size(); ++ri)
         vars.push_back(TTreeReaderValue<double>(reader, reco_vars[ri].name.c_str()));
@@ -19,7 +19,7 @@ int main(int argc, char ** argv)
     */
     //std::string caf = "/pnfs/icarus/scratch/users/mueller/systematics/sample_cv.caf.root";
     std::string base_path = "/pnfs/icarus/scratch/users/mueller/mc_run2/standard_cafs/";
-    std::string nominal = "/exp/icarus/app/users/mueller/sbn_ml_cafmaker/icarus_numu_ml_selection/systematics/cpp/build/output_mc_rev3.root";
+    std::string nominal = "/exp/icarus/app/users/mueller/sbn_ml_cafmaker/icarus_numu_ml_selection/output_mc_crtpmt.root";
     //std::string variation = "/exp/icarus/app/users/mueller/sbn_ml_cafmaker/icarus_numu_ml_selection/systematics/cpp/build/output_sigshape.root";
 
     /**
@@ -26,15 +26,18 @@ def calc_fractional_error(cov, cv):
 
 def read_log(path, tag, header, category_selector=None):
     """
-    Reads an input log file and extracts lines with the specified tag
-    into a Pandas DataFrame.
+    Reads the rows with the specified tag from the output of the
+    selection into a Pandas DataFrame. The output is either a ROOT file
+    with one TTree per tag (the columns are read from the TTree and the
+    header is ignored) or a text log file with tagged CSV lines.
 
     Parameters
     ----------
     path: str
-        The full path of the input log file.
+        The full path of the input ROOT file or log file.
     tag: str
-        The identifier that tags relevant lines in the log file.
+        The identifier that tags relevant lines in the log file (the
+        name of the TTree in a ROOT file).
     header: list[str]
         The list of column names for the CSV file.
     category_selector: callable
@@ -45,18 +48,22 @@ def read_log(path, tag, header, category_selector=None):
     df: Pandas.DataFrame
         The DataFrame containing the requested information.
     """
-    input_file = open(path)
-    lines = input_file.readlines()
-    selected = [x.strip('\n').split(',')[1:] for x in lines if tag in x]
-    selected = [x if x[-1] != '' else x[:-1] for x in selected]
-    #if tag == 'SIGNAL':
-    #    print([x for x in selected if len(x) != len(header)][0])
-    #    print(len(selected[0]))
-    df = pd.DataFrame(selected, columns=header[:len(selected[0])])
-    for k in header[:len(df.columns)]:
-        df[k] = pd.to_numeric(df[k], errors='coerce', downcast='float')
-        if df[k].apply(float.is_integer).all():
-            df[k] = df[k].astype(int)
+    if path.endswith('.root'):
+        with uproot.open(path) as input_file:
+            df = input_file[tag].arrays(library='pd')
+    else:
+        input_file = open(path)
+        lines = input_file.readlines()
+        selected = [x.strip('\n').split(',')[1:] for x in lines if tag in x]
+        selected = [x if x[-1] != '' else x[:-1] for x in selected]
+        #if tag == 'SIGNAL':
+        #    print([x for x in selected if len(x) != len(header)][0])
+        #    print(len(selected[0]))
+        df = pd.DataFrame(selected, columns=header[:len(selected[0])])
+        for k in header[:len(df.columns)]:
+            df[k] = pd.to_numeric(df[k], errors='coerce', downcast='float')
+            if df[k].apply(float.is_integer).all():
+                df[k] = df[k].astype(int)
     if category_selector is not None:
         df = df[df.apply(category_selector, axis=1)]
     return df
@@ -0,0 +1,122 @@
+import argparse
+import numpy as np
+import uproot
+
+SORT_COLUMNS = ['run', 'subrun', 'event', 'nu_id', 'image_id', 'id']
+
+def line_key(line):
+    """
+    Builds the sort key of a line of a text log. Each comma-separated
+    field is compared numerically if it is a number and as text
+    otherwise, so rows are ordered by tag, then run, event, and so on.
+
+    Parameters
+    ----------
+    line: str
+        The line of the log file.
+
+    Returns
+    -------
+    tuple
+        The sort key of the line.
+    """
+    key = list()
+    for field in line.rstrip('\n').split(','):
+        try:
+            key.append((0, float(field), ''))
+        except ValueError:
+            key.append((1, 0.0, field))
+    return tuple(key)
+
+def merge_logs(inputs, output):
+    """
+    Merges the shards of a text log (e.g. output_mc_crtpmt.log) into a
+    single file. The rows are sorted by line_key, so the result does not
+    depend on how the rows were distributed among jobs and threads.
+
+    Parameters
+    ----------
+    inputs: list[str]
+        The full paths of the shards.
+    output: str
+        The full path of the merged log file.
+
+    Returns
+    -------
+    None.
+    """
+    lines = list()
+    for path in inputs:
+        with open(path) as input_file:
+            lines.extend(x if x.endswith('\n') else x + '\n' for x in input_file)
+    lines.sort(key=line_key)
+    with open(output, 'w') as output_file:
+        output_file.writelines(lines)
+
+def merge_trees(inputs, output):
+    """
+    Merges the shards of a ROOT file of row trees (e.g.
+    output_mc_crtpmt.root) into a single file. Each tree is concatenated
+    across the shards and stably sorted by the identifier columns (run,
+    subrun, event, nu_id, image_id, id) that it contains. Objects that
+    are not trees (e.g. spectra) are not handled; use hadd for those.
+
+    Parameters
+    ----------
+    inputs: list[str]
+        The full paths of the shards.
+    output: str
+        The full path of the merged ROOT file.
+
+    Returns
+    -------
+    None.
+    """
+    trees = dict()
+    for path in inputs:
+        with uproot.open(path) as input_file:
+            for name, classname in input_file.classnames(cycle=False).items():
+                if classname != 'TTree':
+                    print(f'Skipping {name} ({classname}) in {path}; use hadd for non-tree objects.')
+                    continue
+                trees.setdefault(name, list()).append(input_file[name].arrays(library='np'))
+
+    with uproot.recreate(output) as output_file:
+        for name, shards in trees.items():
+            columns = {k: np.concatenate([s[k] for s in shards]) for k in shards[0].keys()}
+            keys = [columns[k] for k in reversed(SORT_COLUMNS) if k in columns]
+            if keys:
+                order = np.lexsort(keys)
+                columns = {k: v[order] for k, v in columns.items()}
+            output_file[name] = columns
+
+def main(inputs, output):
+    """
+    Merges the per-job and per-thread shards written by the selection
+    (see include/output_sink.h) into a single output with a
+    deterministic row order.
+
+    Parameters
+    ----------
+    inputs: list[str]
+        The full paths of the shards (all ROOT files or all log files).
+    output: str
+        The full path of the merged output.
+
+    Returns
+    -------
+    None.
+    """
+    if all(x.endswith('.root') for x in inputs):
+        merge_trees(inputs, output)
+    elif not any(x.endswith('.root') for x in inputs):
+        merge_logs(inputs, output)
+    else:
+        raise ValueError('Cannot merge ROOT files and log files together.')
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-o', '--output', required=True)
+    parser.add_argument('inputs', nargs='+')
+    args = parser.parse_args()
+    main(args.inputs, args.output)